@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Params.hpp"
+#include "SampleColoring.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Adaptive anti-aliasing of a colored float frame: a detection pass flags the pixels whose
+/// neighborhood spans a large color difference and compacts them into a device-side list,
+/// then only the listed pixels are iterated again with up to 16 jittered subsamples and
+/// recolored with the average. Smooth regions keep their single sample, so edges get
+/// supersampled quality at a fraction of the cost of supersampling the whole frame.
+/// </summary>
+class AdaptiveSampling
+{
+public:
+    AdaptiveSampling();
+
+    /// <summary>
+    /// Create the kernels and the pixel list
+    /// </summary>
+    /// <param name="earlyExits">IterationStats counter buffer</param>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Program& program, int width, int height, const cl::Buffer& earlyExits);
+
+    /// <summary>
+    /// Recreate the kernels from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Change the frame size, growing the pixel list if it is too small
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Resize(int width, int height);
+
+    /// <summary>
+    /// Refine the image colored from a complete float sample buffer
+    /// </summary>
+    /// <param name="distance">Distance estimates of the samples, NULL for no boundary shading</param>
+    /// <param name="coloring">Owner of the palette LUT</param>
+    /// <param name="params">View, coloring and params.antialiasThreshold</param>
+    /// <param name="seed">Jitter pattern, frames with different seeds place their subsamples differently</param>
+    /// <param name="resolved">Accumulation mean (TemporalAccumulation::GetBuffer) that also takes the refined pixels, or NULL</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer& samples, const cl::Buffer* distance,
+        const SampleColoring& coloring, const Params& params, cl_uint seed = 0, const cl::Buffer* resolved = NULL);
+
+    /// <summary>
+    /// Take over the refined pixel count of the last finished Render, if any
+    /// </summary>
+    void Update();
+
+    /// <summary>
+    /// Share of the pixels the last finished Render refined
+    /// </summary>
+    inline float GetRefinedFraction() const { return m_width * m_height > 0 ? (float)m_refined / ((float)m_width * m_height) : 0.0f; }
+
+private:
+    cl::Context m_context;
+    cl::Kernel m_detectKernel;
+    cl::Kernel m_refineKernel;
+    cl::Buffer m_list;
+    cl::Buffer m_count;
+    // Bound when no accumulation mean takes the refined pixels
+    cl::Buffer m_noResolved;
+    cl::Buffer m_earlyExits;
+    int m_width;
+    int m_height;
+    // Pixels the list holds
+    size_t m_capacity;
+    // Work items of the refinement pass, each strides over the list
+    int m_refineItems;
+
+    cl_int m_refined;
+    cl_int m_readback;
+    cl::Event m_readEvent;
+    bool m_readPending;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Arbitrary precision signed fixed-point number used for deep zoom reference orbits.
+/// One 32-bit limb holds the integer part, the remaining limbs hold the fraction,
+/// so each extra limb adds 32 bits (~9.6 decimal digits) of precision.
+/// </summary>
+class BigFixed
+{
+public:
+    /// <summary>
+    /// Construct zero with the given number of limbs (at least 2)
+    /// </summary>
+    /// <param name="limbs">Total limbs, including the integer limb</param>
+    explicit BigFixed(int limbs = 4);
+
+    /// <summary>
+    /// Convert a double (exactly, as long as limbs allow)
+    /// </summary>
+    static BigFixed FromDouble(double value, int limbs);
+
+    /// <summary>
+    /// Parse a plain decimal string such as "-0.743643887037158704752191506114774"
+    /// </summary>
+    /// <param name="text">Decimal number, optional sign, no exponent</param>
+    /// <param name="limbs">Total limbs, 0 to derive them from the number of digits</param>
+    static BigFixed FromString(const std::string& text, int limbs = 0);
+
+    /// <summary>
+    /// Limbs needed to resolve pixels at the given zoom scale, with guard bits
+    /// </summary>
+    static int LimbsForScale(double scale);
+
+    double ToDouble() const;
+
+    /// <summary>
+    /// Same value with a different precision (truncates or zero-extends the fraction)
+    /// </summary>
+    BigFixed Resized(int limbs) const;
+
+    inline int GetLimbs() const { return (int)m_limbs.size(); }
+
+    BigFixed operator+(const BigFixed& other) const;
+    BigFixed operator-(const BigFixed& other) const;
+    BigFixed operator*(const BigFixed& other) const;
+    bool operator==(const BigFixed& other) const;
+    inline bool operator!=(const BigFixed& other) const { return !(*this == other); }
+
+private:
+    static int CompareMagnitude(const BigFixed& a, const BigFixed& b);
+    static void AddMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& res);
+    static void SubMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& res);
+    bool IsZero() const;
+
+    // Little endian: m_limbs.back() is the integer part
+    std::vector<uint32_t> m_limbs;
+    bool m_negative;
+};
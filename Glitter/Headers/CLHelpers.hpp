@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+/// <summary>
+/// Read a whole OpenCL kernel file into a string
+/// </summary>
+/// <param name="f_name">Path of the kernel file</param>
+/// <returns>File contents, empty on failure</returns>
+std::string ReadFile2(const char* f_name = "kernels.cl");
+
+/// <summary>
+/// Path of a kernel file shipped next to the executable
+/// </summary>
+/// <param name="file_name">Kernel file name, e.g. "mandel.cl"</param>
+/// <returns>Full path of the kernel file</returns>
+std::string GetKernelPath(const char* file_name = "mandel.cl");
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CpuKernels.hpp"
+#include "Simd.hpp"
+
+// Only included by the CpuKernels*.cpp files. Everything stays in an unnamed namespace and
+// avoids shared inline library code, so nothing compiled with wider instruction sets can be
+// picked by the linker for another translation unit.
+namespace
+{
+    // View rectangle at scale 1, must match xMinMax and yMinMax in mandel.cl
+    const float xMin = -2.0f;
+    const float xMax = 0.47f;
+    const float yMin = -1.12f;
+    const float yMax = 1.12f;
+
+    template <class S>
+    void IterateTile(const CpuView& view, int xBegin, int yBegin, int xEnd, int yEnd, float* samples, CpuStats& stats)
+    {
+        typedef typename S::Float Float;
+        typedef typename S::Mask Mask;
+
+        const Float zero = S::Set(0.0f);
+        const Float one = S::Set(1.0f);
+        const Float two = S::Set(2.0f);
+        const Float quarter = S::Set(0.25f);
+        const Float bulbRadius = S::Set(0.0625f);
+        const Float bailout = S::Set(view.bailout);
+        const Float maxIter = S::Set((float)view.maxIter);
+        // Exit kinds per lane, for the counters
+        const Float cardioidExit = S::Set(1.0f);
+        const Float periodicExit = S::Set(2.0f);
+
+        float re[S::width];
+        float iterOut[S::width];
+        float zrOut[S::width];
+        float ziOut[S::width];
+        float kindOut[S::width];
+
+        for (int y = yBegin; y < yEnd; y++)
+        {
+            // Same operation order as IterateSmooth, so results match the float kernel
+            const float y0 = ((yMax - yMin) * (view.height - y) / view.height + yMin) / view.scale + view.dy;
+            const Float ci = S::Set(y0);
+
+            for (int x = xBegin; x < xEnd; x += S::width)
+            {
+                // Lanes past the tile repeat its last pixel and are not stored
+                const int lanes = xEnd - x < S::width ? xEnd - x : S::width;
+                for (int l = 0; l < S::width; l++)
+                {
+                    const int px = l < lanes ? x + l : x + lanes - 1;
+                    re[l] = ((xMax - xMin) * px / view.width + xMin) / view.scale + view.dx;
+                }
+                const Float cr = S::Load(re);
+
+                Float zr = zero;
+                Float zi = zero;
+                Float iter = zero;
+                Float kind = zero;
+                Mask active = S::True();
+
+                // Main cardioid and period-2 bulb
+                if (view.periodCheck >= 0)
+                {
+                    const Float xq = S::Sub(cr, quarter);
+                    const Float q = S::Add(S::Mul(xq, xq), S::Mul(ci, ci));
+                    const Mask cardioid = S::LessEqual(S::Mul(q, S::Add(q, xq)), S::Mul(S::Mul(quarter, ci), ci));
+                    const Float xb = S::Add(cr, one);
+                    const Mask bulb = S::LessEqual(S::Add(S::Mul(xb, xb), S::Mul(ci, ci)), bulbRadius);
+                    const Mask interior = S::Or(cardioid, bulb);
+
+                    iter = S::Select(interior, maxIter, zero);
+                    kind = S::Select(interior, cardioidExit, zero);
+                    active = S::AndNot(active, interior);
+                }
+
+                // All lanes step together, so Brent's window schedule is shared
+                Float savedR = zero;
+                Float savedI = zero;
+                int window = view.periodCheck;
+                int windowEnd = view.periodCheck;
+                for (int i = 0; i < view.maxIter; i++)
+                {
+                    active = S::And(active, S::LessEqual(S::Add(S::Mul(zr, zr), S::Mul(zi, zi)), bailout));
+                    if (!S::Any(active))
+                        break;
+
+                    const Float xTemp = S::Add(S::Sub(S::Mul(zr, zr), S::Mul(zi, zi)), cr);
+                    const Float yTemp = S::Add(S::Mul(S::Mul(two, zr), zi), ci);
+                    zr = S::Select(active, xTemp, zr);
+                    zi = S::Select(active, yTemp, zi);
+                    iter = S::Add(iter, S::Select(active, one, zero));
+
+                    if (view.periodCheck > 0)
+                    {
+                        const Mask periodic = S::And(active, S::And(S::Equal(zr, savedR), S::Equal(zi, savedI)));
+                        if (S::Any(periodic))
+                        {
+                            iter = S::Select(periodic, maxIter, iter);
+                            kind = S::Select(periodic, periodicExit, kind);
+                            active = S::AndNot(active, periodic);
+                        }
+                        if (i + 1 == windowEnd)
+                        {
+                            savedR = zr;
+                            savedI = zi;
+                            window *= 2;
+                            windowEnd += window;
+                        }
+                    }
+                }
+
+                S::Store(iterOut, iter);
+                S::Store(zrOut, zr);
+                S::Store(ziOut, zi);
+                S::Store(kindOut, kind);
+                for (int l = 0; l < lanes; l++)
+                {
+                    float* sample = samples + 2 * ((size_t)y * view.width + x + l);
+                    sample[0] = iterOut[l];
+                    sample[1] = zrOut[l] * zrOut[l] + ziOut[l] * ziOut[l];
+                    if (kindOut[l] == 1.0f)
+                        stats.cardioidExits++;
+                    else if (kindOut[l] == 2.0f)
+                        stats.periodicExits++;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+
+/// <summary>
+/// Instruction sets the CPU kernels are compiled for, picked at runtime
+/// </summary>
+enum class CpuIsa
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512,
+    NEON
+};
+
+/// <summary>
+/// Float view parameters of one frame, the same values the MandelSmooth kernel receives
+/// </summary>
+struct CpuView {
+    int width = 0;
+    int height = 0;
+    float dx = 0.0f;
+    float dy = 0.0f;
+    float scale = 1.0f;
+    int maxIter = 1000;
+    // Squared escape radius, like BAILOUT in mandel.cl
+    float bailout = 65536.0f;
+    // Same meaning as the periodCheck kernel argument
+    int periodCheck = 16;
+};
+
+/// <summary>
+/// Early-out counters, like the earlyExits buffer of the kernels
+/// </summary>
+struct CpuStats {
+    long long cardioidExits = 0;
+    long long periodicExits = 0;
+};
+
+/// <summary>
+/// Iterate the pixels of [xBegin, xEnd) x [yBegin, yEnd) into the float2 sample buffer
+/// (iter, |z|^2) of the whole frame, exactly like IterateSmooth in mandel.cl
+/// </summary>
+typedef void (*CpuIterateFunc)(const CpuView& view, int xBegin, int yBegin, int xEnd, int yEnd, float* samples, CpuStats& stats);
+
+/// <summary>
+/// Widest instruction set supported by this CPU and compiled into the binary
+/// </summary>
+CpuIsa DetectCpuIsa();
+
+const char* CpuIsaName(CpuIsa isa);
+
+/// <summary>
+/// Parse an instruction set name (scalar, sse2, avx2, avx512, neon)
+/// </summary>
+/// <returns>false for unknown names</returns>
+bool CpuIsaFromName(const std::string& name, CpuIsa& isa);
+
+/// <summary>
+/// Iteration function for an instruction set
+/// </summary>
+/// <returns>NULL if the set is not compiled in or not supported by this CPU</returns>
+CpuIterateFunc GetCpuIterate(CpuIsa isa);
+
+// Per instruction set entry points, NULL when the translation unit was built without it
+CpuIterateFunc GetCpuIterateAVX2();
+CpuIterateFunc GetCpuIterateAVX512();
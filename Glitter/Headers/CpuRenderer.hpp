@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Params.hpp"
+#include "CpuKernels.hpp"
+#include "TileScheduler.hpp"
+#include "Palette.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Kernels the CPU backend reproduces
+/// </summary>
+enum class CpuKernel
+{
+    Mandel,
+    MandelSmooth
+};
+
+/// <summary>
+/// CPU reference renderer for hosts without a usable OpenCL device. Reproduces the float
+/// Mandel, MandelSmooth, ColorSamples and GaussianFilter kernels closely enough to check
+/// device output against. Float precision only. Pixels are iterated 4, 8 or 16 at a time
+/// with the widest SIMD instruction set available. Tiles are spread over all cores by a
+/// work-stealing scheduler that starts the tiles which were most expensive in the previous
+/// frame first.
+/// </summary>
+class CpuRenderer
+{
+public:
+    CpuRenderer(int width, int height);
+
+    /// <summary>
+    /// Pick the instruction set and start the worker threads
+    /// </summary>
+    /// <param name="isaName">Instruction set name, empty for the widest supported one</param>
+    /// <param name="threadCount">Worker threads, 0 for all cores</param>
+    /// <param name="tileSize">Edge of the square tiles the frame is scheduled in</param>
+    /// <returns>false if the named set is unknown or unsupported</returns>
+    bool Init(const std::string& isaName = "", int threadCount = 0, int tileSize = 32);
+
+    /// <summary>
+    /// Render one frame into host memory
+    /// </summary>
+    /// <param name="params">View parameters, only float precision is used</param>
+    /// <param name="kernel">Kernel to reproduce</param>
+    /// <returns>true on success</returns>
+    bool Render(const Params& params, CpuKernel kernel = CpuKernel::MandelSmooth);
+
+    /// <summary>
+    /// Palette of the smooth coloring, the default one until set. Baked into the same LUT the
+    /// device samples.
+    /// </summary>
+    void SetPalette(const Palette& palette);
+
+    /// <summary>
+    /// Print per-frame precision, timing and statistics lines, on by default
+    /// </summary>
+    inline void SetVerbose(bool verbose) { m_verbose = verbose; }
+
+    /// <summary>
+    /// Write the last rendered frame as PNG
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool WriteImage(const std::string& path) const;
+
+    /// <summary>
+    /// RGBA8 pixels of the last rendered frame
+    /// </summary>
+    inline const std::vector<unsigned char>& GetPixels() const { return m_pixels; }
+
+    inline CpuIsa GetIsa() const { return m_isa; }
+    inline const CpuStats& GetStats() const { return m_stats; }
+
+private:
+    /// <summary>
+    /// Color the samples of [x0, x1) x [y0, y1) like ColorSamples (smooth) or Mandel
+    /// </summary>
+    void Color(CpuKernel kernel, const Params& params, int x0, int y0, int x1, int y1);
+
+    /// <summary>
+    /// 3x3 binomial filter of the pixels in [x0, x1) x [y0, y1) into m_filtered, like GaussianFilter
+    /// </summary>
+    void Filter(int x0, int y0, int x1, int y1);
+
+    /// <summary>
+    /// Pixel rectangle of a tile
+    /// </summary>
+    void GetTile(int tile, int& x0, int& y0, int& x1, int& y1) const;
+
+    int m_width;
+    int m_height;
+    CpuIsa m_isa;
+    CpuIterateFunc m_iterate;
+    CpuStats m_stats;
+
+    std::unique_ptr<TileScheduler> m_scheduler;
+    int m_tileSize;
+    int m_tilesX;
+    int m_tileCount;
+    // Seconds each tile took last frame, orders the next one
+    std::vector<double> m_tileCosts;
+
+    // (iter, |z|^2) per pixel, like the device sample buffer
+    std::vector<float> m_samples;
+    std::vector<cl_float4> m_lut;
+    float m_period;
+    bool m_verbose;
+    std::vector<unsigned char> m_pixels;
+    std::vector<unsigned char> m_filtered;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "BigFixed.hpp"
+#include "Progressive.hpp"
+#include <CL/cl.hpp>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Perturbation theory deep zoom engine. A single reference orbit is computed on the host
+/// in arbitrary precision at the view offset (dx, dy) and uploaded once; the MandelPerturb
+/// kernel then iterates only the per-pixel delta in double (or float without cl_khr_fp64).
+/// </summary>
+class DeepZoom
+{
+public:
+    DeepZoom();
+
+    /// <summary>
+    /// Create the perturbation kernel from an already built program
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Device& device, const cl::Program& program);
+
+    /// <summary>
+    /// Recreate the kernel from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Set the reference point from decimal strings (any precision)
+    /// </summary>
+    void SetCenter(const std::string& re, const std::string& im);
+
+    /// <summary>
+    /// Set the reference point from doubles
+    /// </summary>
+    void SetCenter(double re, double im);
+
+    /// <summary>
+    /// Move the reference point by a (small) offset, keeping full precision
+    /// </summary>
+    void Offset(double re, double im);
+
+    /// <summary>
+    /// Iterate the view into the sample buffer, recomputing the reference orbit if needed
+    /// </summary>
+    /// <param name="queue">Queue of the context given in Init</param>
+    /// <param name="samples">float2 per pixel, kept between passes of a progressive render</param>
+    /// <param name="scale">Zoom scale</param>
+    /// <param name="maxIter">Iteration limit the program was built with</param>
+    /// <param name="bailout">Escape radius the program was built with</param>
+    /// <param name="event">Optional event of the kernel, e.g. for profiling</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const cl::Buffer& samples, int width, int height,
+        double scale, int maxIter, double bailout, const RenderPass& pass = RenderPass(), cl::Event* event = NULL);
+
+    inline double GetCenterRe() const { return m_centerRe.ToDouble(); }
+    inline double GetCenterIm() const { return m_centerIm.ToDouble(); }
+    inline int GetReferenceLength() const { return m_orbitLength; }
+
+    /// <summary>
+    /// Deepest scale the delta type can resolve (float deltas underflow long before doubles)
+    /// </summary>
+    inline double GetMaxScale() const { return m_useDouble ? 1e300 : 1e30; }
+
+private:
+    void ComputeReferenceOrbit(int limbs, int maxIter, double bailout);
+
+    BigFixed m_centerRe;
+    BigFixed m_centerIm;
+
+    cl::Context m_context;
+    cl::Kernel m_kernel;
+    cl::Buffer m_orbitBuffer;
+    bool m_useDouble;
+
+    // Reference orbit cache, valid for the current center, precision and iteration limit
+    bool m_orbitDirty;
+    int m_orbitLimbs;
+    int m_orbitMaxIter;
+    double m_orbitBailout;
+    int m_orbitLength;
+    std::vector<double> m_orbit;
+};
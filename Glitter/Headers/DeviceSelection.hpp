@@ -0,0 +1,64 @@
+#pragma once
+
+#include <CL/cl.hpp>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// What the selected device has to support
+/// </summary>
+enum class DeviceMode
+{
+    // Window with CL/GL shared textures
+    Interactive,
+    // Plain context rendering into CL images
+    Headless
+};
+
+/// <summary>
+/// Capabilities of one device of one platform
+/// </summary>
+struct DeviceInfo {
+    cl::Platform platform;
+    cl::Device device;
+    // Position in the enumeration over all platforms, as accepted by --device
+    int index = 0;
+    std::string name;
+    std::string platformName;
+    cl_device_type type = 0;
+    cl_uint computeUnits = 0;
+    cl_uint clock = 0;
+    bool fp64 = false;
+    bool images = false;
+    bool glSharing = false;
+    // Shares memory with the host, usually an integrated GPU
+    bool unifiedMemory = false;
+
+    /// <summary>
+    /// Whether the device can run a mode at all
+    /// </summary>
+    bool Supports(DeviceMode mode) const;
+
+    /// <summary>
+    /// Rough throughput estimate for ranking, 0 when the mode is unsupported
+    /// </summary>
+    double GetScore(DeviceMode mode) const;
+};
+
+/// <summary>
+/// Query every device of every platform
+/// </summary>
+std::vector<DeviceInfo> EnumerateDevices();
+
+/// <summary>
+/// Print the capability table with the scores for a mode
+/// </summary>
+void PrintDevices(const std::vector<DeviceInfo>& devices, DeviceMode mode);
+
+/// <summary>
+/// Devices to try for a mode, best first. A request picks exactly one device, either by
+/// its index or by a case-insensitive part of the device or platform name.
+/// </summary>
+/// <param name="request">--device value, empty to rank all supported devices</param>
+/// <returns>Empty when nothing matches or nothing supports the mode</returns>
+std::vector<DeviceInfo> RankDevices(const std::vector<DeviceInfo>& devices, DeviceMode mode, const std::string& request);
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Params.hpp"
+#include "MandelVariants.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Exponential map renderer for zoom videos. A zoom into a fixed target is iterated once
+/// as a log-polar strip around the target (ExpMapStrip): strip samples are square, and
+/// every width / (2 pi) rows zoom in by a factor of e. Each frame of the zoom is then
+/// resampled from the strip into the sample buffer (ExpMapFrame) and colored as usual.
+/// Consecutive frames share almost all of their strip rows, so a zoom iterates a small
+/// fraction of the samples rendering every frame would. Strip rows live in a device ring
+/// that only holds the rows the current frame reaches.
+/// </summary>
+class ExpMap
+{
+public:
+    ExpMap();
+
+    /// <summary>
+    /// Create the kernels for a frame size
+    /// </summary>
+    /// <param name="earlyExits">IterationStats counter buffer</param>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Device& device, const cl::Context& context, const cl::Program& program, int width, int height,
+        const cl::Buffer& earlyExits);
+
+    /// <summary>
+    /// Recreate the kernels from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Start a zoom into (params.dx, params.dy) from params.scale, allocating the strip ring
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Begin(const Params& params);
+
+    /// <summary>
+    /// Iterate the strip rows the frame at params.scale reaches that are not rendered yet,
+    /// then resample the frame into the sample buffer. Scales must not decrease.
+    /// </summary>
+    /// <param name="variants">Picks the arithmetic of each band of strip rows</param>
+    /// <param name="samples">float2 per pixel, fully valid afterwards</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const MandelVariants& variants, const cl::Buffer& samples, const Params& params);
+
+    inline int GetStripWidth() const { return m_stripWidth; }
+
+    /// <summary>
+    /// Strip samples iterated since Begin
+    /// </summary>
+    inline long long GetIteratedSamples() const { return m_iteratedSamples; }
+
+private:
+    // Strip rows iterated per kernel launch, each launch picks its own precision
+    static const int bandRows = 256;
+
+    /// <summary>
+    /// Iterate strip rows [rowBegin, rowEnd) into the ring
+    /// </summary>
+    bool RenderRows(const cl::CommandQueue& queue, const MandelVariants& variants, const Params& params, int rowBegin, int rowEnd);
+
+    int m_width;
+    int m_height;
+    bool m_hasFp64;
+    cl_ulong m_maxAlloc;
+
+    cl::Context m_context;
+    cl::Kernel m_floatKernel;
+    cl::Kernel m_dsKernel;
+    cl::Kernel m_doubleKernel;
+    cl::Kernel m_frameKernel;
+    cl::Buffer m_strip;
+    cl::Buffer m_earlyExits;
+
+    // Zoom target and strip geometry: row 0 has radius m_radius0, a row m_angleStep of log radius
+    double m_dx;
+    double m_dy;
+    double m_startScale;
+    double m_radius0;
+    double m_angleStep;
+    int m_stripWidth;
+    int m_ringRows;
+    // Rows a frame spans from its corners to half a pixel from the target
+    double m_frameRows;
+
+    // Strip rows [m_firstRow, m_nextRow) are in the ring
+    int m_firstRow;
+    int m_nextRow;
+    long long m_iteratedSamples;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <CL/cl.hpp>
+#include <vector>
+
+/// <summary>
+/// Shared CL/GL render targets kept in flight, so the device computes one frame while the
+/// previous one is blitted and the GUI drawn. CL writes a target between BeginFrame and
+/// EndFrame; Present shows the newest target queued in an earlier loop iteration, so the
+/// display trails the device by one frame. With cl_khr_gl_event, acquire and release
+/// synchronize implicitly; otherwise GL fences and the CL release events are waited on, but
+/// only one frame after they were issued, when they have normally completed already.
+/// Targets are allocated in size classes, rounded up to multiples of sizeClass pixels, and
+/// the frame occupies their top-left corner, so most resizes only change the frame size.
+/// The last poolSize classes stay allocated, so dragging a window edge back and forth does
+/// not recreate the shared textures.
+/// </summary>
+class FramePipeline
+{
+public:
+    FramePipeline();
+
+    /// <summary>
+    /// Create the GL textures, their framebuffers, the shared CL images and the filter scratch image
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Device& device, int width, int height);
+
+    /// <summary>
+    /// Change the frame size, switching to the targets of its size class. The CL queue must
+    /// be idle; frames in flight in another class are dropped.
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Resize(int width, int height);
+
+    /// <summary>
+    /// Pick a free target and enqueue its acquisition by CL
+    /// </summary>
+    /// <returns>Image to render the frame into</returns>
+    const cl::Image2D& BeginFrame(const cl::CommandQueue& queue);
+
+    /// <summary>
+    /// Enqueue the release of the target back to GL and flush, without waiting
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool EndFrame(const cl::CommandQueue& queue);
+
+    /// <summary>
+    /// Blit the newest finished frame to the default framebuffer
+    /// </summary>
+    void Present(int windowWidth, int windowHeight);
+
+    /// <summary>
+    /// Delete the GL objects, must run while the GL context is still alive
+    /// </summary>
+    void Cleanup();
+
+    /// <summary>
+    /// CL only image for passes that cannot run in place (filter)
+    /// </summary>
+    inline const cl::Image2D& GetScratch() const { return m_sets[0].scratch; }
+
+    inline bool HasImplicitSync() const { return m_implicitSync; }
+
+    /// <summary>
+    /// Whether a queued frame still has to be shown by a later Present
+    /// </summary>
+    inline bool HasPendingFrame() const { return m_queued >= 0 || m_ready >= 0; }
+
+private:
+    static const int targetCount = 2;
+    static const int sizeClass = 256;
+    static const int poolSize = 2;
+
+    struct Target {
+        GLuint texture = 0;
+        GLuint framebuffer = 0;
+        cl::Image2D image;
+        cl::Event released;
+        GLsync fence = 0;
+        // Size of the frame last rendered into the target
+        int width = 0;
+        int height = 0;
+    };
+
+    struct TargetSet {
+        int width = 0;
+        int height = 0;
+        Target targets[targetCount];
+        cl::Image2D scratch;
+    };
+
+    bool CreateSet(TargetSet& set, int width, int height);
+    void DeleteSet(TargetSet& set);
+
+    cl::Context m_context;
+    // Most recently used size class first, m_sets[0] holds the targets in use
+    std::vector<TargetSet> m_sets;
+    int m_width;
+    int m_height;
+
+    // Target between BeginFrame and EndFrame, queued this iteration, queued earlier and on screen
+    int m_current;
+    int m_queued;
+    int m_ready;
+    int m_shown;
+
+    bool m_implicitSync;
+};
@@ -2,6 +2,7 @@
 
 #include "Timer.hpp"
 #include <string>
+#include <vector>
 #include <GLFW/glfw3.h>
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
@@ -58,8 +59,50 @@ public:
     bool gui_enabled;
     float animationTime;
     float animationSpeed;
+    double scale;
+    int maxIter;
+    double bailout;
+    int programCount;
+    int programBinaryHits;
+    const char* precision;
+    bool deepZoom;
+    int referenceLength;
+    bool progressive;
+    int progressivePass;
+    bool reprojected;
+    bool mariani;
+    float marianiFilled;
+    bool interiorChecks;
+    bool histogram;
+    bool distanceEstimate;
+    const char* palette;
+    // Coloring settings, edited in place like maxIter
+    float paletteOffset;
+    float paletteDensity;
+    float exposure;
+    bool paletteCycle;
+    float boundaryWidth;
+    bool antialias;
+    float antialiasThreshold;
+    float antialiasRefined;
+    bool dynamicResolution;
+    int renderStep;
+    float kernelTime;
+    float frameBudget;
+    bool accumulate;
+    int accumulatedFrames;
+    int accumulateFrames;
+    bool rendered;
+    bool recolored;
+    int cardioidExits;
+    int periodicExits;
+    // One line per device of a split render
+    std::vector<std::string> splitDevices;
 
 private:
     GLFWwindow* p_window;
     Timer& m_timer;
+    // Iteration settings being typed, copied to maxIter and bailout once the edit is committed
+    int m_maxIterEdit;
+    double m_bailoutEdit;
 };
\ No newline at end of file
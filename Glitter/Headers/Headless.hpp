@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Params.hpp"
+#include "AdaptiveSampling.hpp"
+#include "TemporalAccumulation.hpp"
+#include "Options.hpp"
+#include "DeepZoom.hpp"
+#include "ExpMap.hpp"
+#include "MandelVariants.hpp"
+#include "MarianiSilver.hpp"
+#include "IterationStats.hpp"
+#include "HistogramColoring.hpp"
+#include "SampleColoring.hpp"
+#include "ProgramCache.hpp"
+#include <CL/cl.hpp>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Write RGBA8 pixels as PNG
+/// </summary>
+/// <returns>true on success</returns>
+bool WritePng(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels);
+
+/// <summary>
+/// Render one frame to options.output with OpenCL, falling back to the CPU backend when no
+/// device works, render a zoom sequence for --sequence, or compare both backends for --cpu-check
+/// </summary>
+/// <returns>true on success</returns>
+bool RunHeadless(const Options& options);
+
+/// <summary>
+/// Offscreen renderer that owns a plain OpenCL context (no GLFW window, no GL sharing)
+/// and writes frames to disk. Works with any device, including CPU ICDs.
+/// </summary>
+class HeadlessRenderer
+{
+public:
+    HeadlessRenderer(int width, int height);
+
+    /// <summary>
+    /// Pick a device, create context and queue and build the kernels
+    /// </summary>
+    /// <param name="params">Iteration settings the program is first built for</param>
+    /// <param name="deviceRequest">Device index or part of its name, empty for the best scoring one</param>
+    /// <returns>true on success</returns>
+    bool Init(const Params& params, const std::string& deviceRequest = "");
+
+    /// <summary>
+    /// Palette of the coloring passes, the default one until set
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetPalette(const Palette& palette);
+
+    /// <summary>
+    /// Render one frame into the owned image and read it back to host memory
+    /// </summary>
+    /// <param name="params">View parameters</param>
+    /// <returns>true on success</returns>
+    bool Render(const Params& params);
+
+    /// <summary>
+    /// Start a zoom into (params.dx, params.dy) from params.scale rendered through the
+    /// exponential map, see ExpMap
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool BeginExpMap(const Params& params);
+
+    /// <summary>
+    /// Render a frame of the zoom started with BeginExpMap, resampled from the strip, and read
+    /// it back to host memory. Only params.scale may change between frames and must not
+    /// decrease.
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool RenderExpMap(const Params& params);
+
+    /// <summary>
+    /// Exponential map of the zoom started with BeginExpMap
+    /// </summary>
+    inline const ExpMap& GetExpMap() const { return m_expMap; }
+
+    /// <summary>
+    /// Print per-frame precision, timing and statistics lines, on by default
+    /// </summary>
+    inline void SetVerbose(bool verbose) { m_verbose = verbose; }
+
+    /// <summary>
+    /// Write the last rendered frame as PNG
+    /// </summary>
+    /// <param name="path">Output file</param>
+    /// <returns>true on success</returns>
+    bool WriteImage(const std::string& path) const;
+
+    /// <summary>
+    /// RGBA8 pixels of the last rendered frame
+    /// </summary>
+    inline const std::vector<unsigned char>& GetPixels() const { return m_pixels; }
+
+    /// <summary>
+    /// Perturbation engine used when params.deepZoom is set
+    /// </summary>
+    inline DeepZoom& GetDeepZoom() { return m_deepZoom; }
+
+    /// <summary>
+    /// Float, double-single and double variants, picks the precision of a view
+    /// </summary>
+    inline const MandelVariants& GetVariants() const { return m_variants; }
+
+private:
+    /// <summary>
+    /// Switch every kernel to the program built for the iteration settings
+    /// </summary>
+    bool UseProgram(const Params& params);
+
+    /// <summary>
+    /// Color the sample buffer, anti-alias and accumulate it when refine is set (float samples
+    /// only), filter and read the frame back
+    /// </summary>
+    bool Resolve(const Params& params, bool refine);
+
+    int m_width;
+    int m_height;
+    bool m_verbose;
+
+    cl::Device m_device;
+    cl::Context m_context;
+    cl::CommandQueue m_queue;
+    ProgramCache m_programCache;
+    cl::Kernel m_filterKernel;
+    cl::Image2D m_image;
+    cl::Image2D m_filterImage;
+    cl::Buffer m_samples;
+    cl::Buffer m_distance;
+    DeepZoom m_deepZoom;
+    ExpMap m_expMap;
+    MandelVariants m_variants;
+    MarianiSilver m_mariani;
+    IterationStats m_stats;
+    HistogramColoring m_histogram;
+    SampleColoring m_coloring;
+    AdaptiveSampling m_adaptive;
+    TemporalAccumulation m_temporal;
+
+    std::string m_kernelSource;
+    std::vector<unsigned char> m_pixels;
+};
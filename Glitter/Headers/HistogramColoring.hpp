@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Params.hpp"
+#include "SampleColoring.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Histogram-equalized coloring of a sample buffer, entirely on the device: work-group
+/// histograms in local memory, a per-bin merge, a single work-group prefix sum for the
+/// cumulative distribution and a coloring pass. No host round trips.
+/// </summary>
+class HistogramColoring
+{
+public:
+    HistogramColoring();
+
+    /// <summary>
+    /// Create the kernels and the histogram buffers
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Device& device, const cl::Program& program, int width, int height);
+
+    /// <summary>
+    /// Recreate the kernels from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Change the frame size, the histogram buffers do not depend on it
+    /// </summary>
+    void Resize(int width, int height);
+
+    /// <summary>
+    /// Enqueue the four passes, recoloring the whole image from a complete sample buffer
+    /// </summary>
+    /// <param name="coloring">Owner of the palette LUT</param>
+    /// <param name="params">Exposure</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer& samples,
+        const SampleColoring& coloring, const Params& params);
+
+private:
+    // Must match HIST_BINS in mandel.cl
+    static const int maxBins = 4096;
+    // Work-group size cap, a power of two
+    static const int maxGroupSize = 256;
+
+    cl::Device m_device;
+    cl::Kernel m_localKernel;
+    cl::Kernel m_mergeKernel;
+    cl::Kernel m_scanKernel;
+    cl::Kernel m_colorKernel;
+    cl::Buffer m_partials;
+    cl::Buffer m_histogram;
+    cl::Buffer m_cdf;
+    int m_width;
+    int m_height;
+    int m_groups;
+    int m_localSize;
+    int m_scanSize;
+};
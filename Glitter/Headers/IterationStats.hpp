@@ -0,0 +1,48 @@
+#pragma once
+
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Device-side counters of pixels that skipped the escape-time loop: earlyExits[0] for the
+/// main cardioid / period-2 bulb test and earlyExits[1] for periodicity detection
+/// </summary>
+class IterationStats
+{
+public:
+    IterationStats();
+
+    /// <summary>
+    /// Create the counter buffer
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context);
+
+    /// <summary>
+    /// Zero the counters before a frame
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Reset(const cl::CommandQueue& queue);
+
+    /// <summary>
+    /// Read the counters after a frame. A non-blocking read lands once the device gets
+    /// there and is picked up by Update.
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Read(const cl::CommandQueue& queue, bool blocking = true);
+
+    /// <summary>
+    /// Take over the counters of a finished non-blocking read, if any
+    /// </summary>
+    void Update();
+
+    inline const cl::Buffer& GetBuffer() const { return m_buffer; }
+    inline int GetCardioidExits() const { return m_counts[0]; }
+    inline int GetPeriodicExits() const { return m_counts[1]; }
+
+private:
+    cl::Buffer m_buffer;
+    cl_int m_counts[2];
+    cl_int m_readback[2];
+    cl::Event m_readEvent;
+    bool m_readPending;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Params.hpp"
+#include "Progressive.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Arithmetic used to iterate a view, cheapest first
+/// </summary>
+enum class Precision
+{
+    Float,
+    DoubleSingle,
+    Double,
+    Perturbation
+};
+
+const char* PrecisionName(Precision precision);
+
+/// <summary>
+/// Float, double-single and double variants of MandelSmooth, with automatic selection of
+/// the cheapest variant that still resolves a pixel at the current zoom
+/// </summary>
+class MandelVariants
+{
+public:
+    MandelVariants();
+
+    /// <summary>
+    /// Create the variant kernels available on the device
+    /// </summary>
+    /// <param name="earlyExits">IterationStats counter buffer</param>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Device& device, const cl::Program& program, const cl::Buffer& earlyExits);
+
+    /// <summary>
+    /// Recreate the kernels from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Pick the arithmetic for a view. Without params.autoPrecision only float
+    /// (or perturbation, when params.deepZoom is set) is used.
+    /// </summary>
+    /// <param name="params">View parameters</param>
+    /// <param name="width">Render width in pixels</param>
+    Precision Select(const Params& params, int width) const;
+
+    /// <summary>
+    /// Cheapest arithmetic that resolves samples spacing apart around (dx, dy)
+    /// </summary>
+    Precision SelectForSpacing(double spacing, double dx, double dy) const;
+
+    /// <summary>
+    /// Enqueue the MandelSmooth variant for a precision other than Perturbation. Only samples
+    /// are written, SampleColoring turns them into pixels.
+    /// </summary>
+    /// <param name="samples">float2 per pixel, kept between passes of a progressive render</param>
+    /// <param name="event">Optional event of the kernel, e.g. for profiling</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const cl::Buffer& samples, int width, int height,
+        const Params& params, Precision precision, const RenderPass& pass = RenderPass(), cl::Event* event = NULL);
+
+    /// <summary>
+    /// Enqueue MandelSmoothDE, the float variant that also writes the exterior distance
+    /// estimate of every sample it computes, in pixels
+    /// </summary>
+    /// <param name="distance">float per pixel, laid out like the samples</param>
+    /// <returns>true on success</returns>
+    bool RenderDistance(const cl::CommandQueue& queue, const cl::Buffer& samples, const cl::Buffer& distance, int width, int height,
+        const Params& params, const RenderPass& pass = RenderPass(), cl::Event* event = NULL);
+
+    inline bool HasFp64() const { return m_hasFp64; }
+
+private:
+    cl::Kernel m_floatKernel;
+    cl::Kernel m_dsKernel;
+    cl::Kernel m_doubleKernel;
+    cl::Kernel m_distanceKernel;
+    cl::Buffer m_earlyExits;
+    bool m_hasFp64;
+    bool m_isGpu;
+};
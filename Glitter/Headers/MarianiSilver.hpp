@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Params.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Mariani-Silver (rectangle boundary) renderer. Only tile borders are iterated; tiles whose
+/// border is entirely inside the set are filled, the rest are split in four, level by level. The host drives the
+/// levels over device-side tile queues and only reads back the three queue sizes per level.
+/// Float precision only.
+/// </summary>
+class MarianiSilver
+{
+public:
+    MarianiSilver();
+
+    /// <summary>
+    /// Create kernels and tile queues for a frame size
+    /// </summary>
+    /// <param name="earlyExits">IterationStats counter buffer</param>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Program& program, int width, int height, const cl::Buffer& earlyExits);
+
+    /// <summary>
+    /// Recreate the kernels from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Change the frame size: rebuild the root tiles, grow the tile queues if they are too small
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Resize(int width, int height);
+
+    /// <summary>
+    /// Render a full frame into the sample buffer, coloring is left to SampleColoring
+    /// </summary>
+    /// <param name="samples">float2 per pixel sample buffer, fully valid afterwards</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const cl::Buffer& samples, const Params& params);
+
+    /// <summary>
+    /// Fraction of the last frame's pixels that were filled instead of iterated
+    /// </summary>
+    inline float GetFilledFraction() const { return m_filledFraction; }
+
+private:
+    static const int startTileSize = 64;
+    static const int minTileSize = 8;
+
+    int m_width;
+    int m_height;
+    // Tiles each queue holds
+    size_t m_tileCapacity;
+
+    cl::Context m_context;
+    cl::Kernel m_borderKernel;
+    cl::Kernel m_classifyKernel;
+    cl::Kernel m_fillKernel;
+    cl::Kernel m_directKernel;
+
+    // Tile queues: root level, ping-ponged split levels, fill and direct
+    cl::Buffer m_rootTiles;
+    cl::Buffer m_levelTiles[2];
+    cl::Buffer m_fillTiles;
+    cl::Buffer m_directTiles;
+    cl::Buffer m_counts;
+    cl::Buffer m_earlyExits;
+    int m_rootCount;
+
+    float m_filledFraction;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Params.hpp"
+#include "MandelVariants.hpp"
+#include "IterationStats.hpp"
+#include "ProgramCache.hpp"
+#include "SampleColoring.hpp"
+#include <CL/cl.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Split rendering over every OpenCL device of every platform. Each device gets its own
+/// context, queue and program and renders a horizontal band of the frame; the bands are
+/// read back and merged on the host, first split by the device scores of DeviceSelection. After each frame the band heights are rebalanced by
+/// the rows per second every device achieved, measured with kernel profiling events.
+/// </summary>
+class MultiDevice
+{
+public:
+    MultiDevice(int width, int height);
+
+    /// <summary>
+    /// Create a context, queue and program for every device with image support
+    /// </summary>
+    /// <param name="params">Iteration settings the programs are first built for</param>
+    /// <returns>true when at least one device is usable</returns>
+    bool Init(const Params& params);
+
+    /// <summary>
+    /// Arithmetic for a view, the precision every device can resolve it with.
+    /// Perturbation is not split and falls back to the most precise variant.
+    /// </summary>
+    Precision Select(const Params& params) const;
+
+    /// <summary>
+    /// Reallocate the band images and sample buffers of every device for a new frame size
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Resize(int width, int height);
+
+    /// <summary>
+    /// Upload a palette to every device
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetPalette(const Palette& palette);
+
+    /// <summary>
+    /// Render and color the bands on all devices, wait for them and merge into host memory
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Render(const Params& params, Precision precision);
+
+    /// <summary>
+    /// Apply GaussianFilter to the merged frame on the first device
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Filter();
+
+    /// <summary>
+    /// Write the merged frame into an image of another context, e.g. the shared GL texture
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Upload(const cl::CommandQueue& queue, const cl::Image2D& image) const;
+
+    /// <summary>
+    /// RGBA8 pixels of the last merged frame
+    /// </summary>
+    inline const std::vector<unsigned char>& GetPixels() const { return m_pixels; }
+
+    inline int GetDeviceCount() const { return (int)m_slices.size(); }
+    const std::string& GetDeviceName(int device) const;
+
+    /// <summary>
+    /// Fraction of the rows the device renders next frame
+    /// </summary>
+    double GetShare(int device) const;
+
+    /// <summary>
+    /// Kernel time of the device's band in the last frame, in milliseconds
+    /// </summary>
+    double GetKernelTime(int device) const;
+
+    long long GetCardioidExits() const;
+    long long GetPeriodicExits() const;
+
+private:
+    struct Slice {
+        cl::Device device;
+        std::string name;
+        cl::Context context;
+        cl::CommandQueue queue;
+        ProgramCache programCache;
+        const cl::Program* program = NULL;
+        MandelVariants variants;
+        SampleColoring coloring;
+        IterationStats stats;
+        cl::Image2D image;
+        cl::Buffer samples;
+        cl::Event kernelEvent;
+        cl::Event readEvent;
+        double share = 0.0;
+        int rowBegin = 0;
+        int rowEnd = 0;
+        double kernelTime = 0.0;
+    };
+
+    bool InitSlice(Slice& slice, const Params& params);
+
+    /// <summary>
+    /// Turn the shares into consecutive row bands, at least minRows each while the frame has enough rows
+    /// </summary>
+    void Partition();
+
+    /// <summary>
+    /// Move the shares towards the measured throughput of each device
+    /// </summary>
+    void Rebalance();
+
+    int m_width;
+    int m_height;
+    std::string m_kernelSource;
+    std::vector<std::unique_ptr<Slice>> m_slices;
+    cl::Kernel m_filterKernel;
+    cl::Image2D m_filterImage;
+    std::vector<unsigned char> m_pixels;
+};
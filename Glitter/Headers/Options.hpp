@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Params.hpp"
+#include <string>
+
+/// <summary>
+/// Startup options parsed from the command line
+/// </summary>
+struct Options {
+    bool headless = false;
+    // Split frames over every OpenCL device found
+    bool multiDevice = false;
+    // Device index or part of its name, empty to pick the best scoring one
+    std::string device;
+    // Print the device table and exit
+    bool listDevices = false;
+    // CPU backend instead of OpenCL (headless), also used when no OpenCL device works
+    bool cpu = false;
+    // Render with both backends and compare the pixels (headless)
+    bool cpuCheck = false;
+    // CPU backend reproduces the basic Mandel kernel instead of MandelSmooth
+    bool basic = false;
+    // CPU instruction set name, empty to detect
+    std::string isa;
+    // CPU worker threads, 0 for all cores
+    int threads = 0;
+    // Edge of the square tiles the CPU backend schedules
+    int tileSize = 32;
+    int width = 1920;
+    int height = 1080;
+    std::string output = "mandelbrot.png";
+    // Full precision deep zoom reference point, overrides dx/dy when given
+    std::string centerRe;
+    std::string centerIm;
+    // Built-in palette name or palette file, empty for the default palette
+    std::string palette;
+    // Zoom video output (headless): a .y4m stream or a PNG frame pattern, empty for one frame
+    std::string sequence;
+    // Keyframe file of the zoom path, empty to zoom into the start view's center
+    std::string keyframes;
+    int fps = 30;
+    // Frame count, 0 for duration * fps + 1
+    int frames = 0;
+    // Seconds of the straight zoom without keyframes
+    double duration = 10.0;
+    // Scale the straight zoom ends at, 0 for 1000 times the start scale
+    double zoomEnd = 0.0;
+    // PNG writer threads, 0 for all cores but one
+    int writers = 0;
+    // Resample the sequence frames from one exponential map strip instead of iterating each
+    bool expMap = false;
+    Params params;
+};
+
+/// <summary>
+/// Parse command line arguments into startup options.
+/// Unknown arguments are reported and ignored.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns>Parsed options, defaults for anything not given</returns>
+Options ParseOptions(int argc, char* argv[]);
+
+/// <summary>
+/// Print command line usage
+/// </summary>
+void PrintUsage();
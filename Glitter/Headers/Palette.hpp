@@ -0,0 +1,85 @@
+#pragma once
+
+#include <CL/cl.hpp>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Cyclic color gradient, built in or loaded from a file, baked into the LUT the coloring
+/// kernels sample with hardware linear filtering.
+///
+/// Palette files are text, one color per line: "r g b" (0-255) for evenly spaced colors or
+/// "position r g b" with positions in [0, 1) for a gradient with explicit stops. An optional
+/// "period N" line sets the iterations one cycle spans at palette density 1, by default the
+/// number of colors. Any image stb_image reads is also accepted, its middle row being the
+/// evenly spaced colors. Lines starting with # are comments.
+/// </summary>
+class Palette
+{
+public:
+    // Entries of the baked LUT
+    static const int lutSize = 4096;
+
+    /// <summary>
+    /// The classic 16 color palette
+    /// </summary>
+    Palette();
+
+    /// <summary>
+    /// Names of the built-in palettes, the first one is the default
+    /// </summary>
+    static std::vector<std::string> GetBuiltinNames();
+
+    /// <summary>
+    /// Select a built-in palette
+    /// </summary>
+    /// <returns>false for unknown names</returns>
+    bool SetBuiltin(const std::string& name);
+
+    /// <summary>
+    /// Load a palette from a text or image file
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Load(const std::string& path);
+
+    /// <summary>
+    /// Built-in name, a file path, or the name of a file in the palettes directory next to
+    /// the executable (without the .pal extension)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Find(const std::string& nameOrPath);
+
+    /// <summary>
+    /// Sample the gradient at equally spaced texel centers, one full cycle
+    /// </summary>
+    std::vector<cl_float4> Bake(int entries = lutSize) const;
+
+    inline const std::string& GetName() const { return m_name; }
+
+    /// <summary>
+    /// Iterations one palette cycle spans at palette density 1
+    /// </summary>
+    inline float GetPeriod() const { return m_period; }
+
+    /// <summary>
+    /// Read a baked LUT like the device sampler: normalized coordinate, linear filtering,
+    /// repeating or clamped to the edge
+    /// </summary>
+    static cl_float4 Sample(const std::vector<cl_float4>& lut, float u, bool repeat);
+
+private:
+    /// <summary>
+    /// Replace the stops, sorted by position
+    /// </summary>
+    void SetStops(const std::vector<float>& positions, const std::vector<cl_float4>& colors, float period);
+
+    /// <summary>
+    /// Gradient color at a position in [0, 1), wrapping from the last stop to the first
+    /// </summary>
+    cl_float4 Evaluate(float position) const;
+
+    std::string m_name;
+    std::vector<float> m_positions;
+    std::vector<cl_float4> m_colors;
+    float m_period;
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+// Limits of the runtime iteration and bailout settings; the bailout bound keeps the
+// squared escape radius inside the integer part of BigFixed
+const int minMaxIter = 16;
+const int maxMaxIter = 1 << 20;
+const double minBailout = 2.0;
+const double maxBailout = 1024.0;
+// Limits of the coloring settings
+const float minPaletteDensity = 0.01f;
+const float maxPaletteDensity = 64.0f;
+const float maxExposure = 16.0f;
+const float maxBoundaryWidth = 16.0f;
+const float maxAntialiasThreshold = 1.0f;
+const int maxAccumulateFrames = 4096;
+// Shortest kernel time budget of dynamic resolution, in milliseconds
+const float minFrameBudget = 1.0f;
+
+/// <summary>
+/// View and animation parameters shared by the interactive and headless renderers
+/// </summary>
+struct Params {
+    double dx = 0;
+    double dy = 0;
+    double scale = 1.0;
+    int maxIter = 1000;
+    double bailout = 256.0;
+    bool filterOn = false;
+    bool deepZoom = false;
+    bool autoPrecision = true;
+    bool progressive = false;
+    bool reproject = true;
+    bool mariani = false;
+    // Moving views render at the coarsest sample grid that keeps the iteration kernel within
+    // frameBudget milliseconds (ResolutionController), still views complete at full resolution
+    bool dynamicResolution = false;
+    float frameBudget = 16.0f;
+    // Histogram-equalized palette instead of the smooth iteration palette
+    bool histogram = false;
+    // Float views also write the exterior distance estimate (MandelSmoothDE)
+    bool distanceEstimate = false;
+    // Float views refine pixels on high-contrast edges with jittered subsamples (AdaptiveSampling)
+    bool antialias = false;
+    // Coloring pass only, changing these never iterates again: palette shift in iterations and
+    // palette cycles per palette period (smooth palette), brightness scale (both palettes)
+    float paletteOffset = 0.0f;
+    float paletteDensity = 1.0f;
+    float exposure = 1.0f;
+    // Escaped pixels closer to the set than this many pixels fade to black (smooth palette,
+    // distance estimate on), 0 to only compute the estimate
+    float boundaryWidth = 1.0f;
+    // Largest color channel difference within a pixel's 3x3 neighborhood left unrefined (antialias on)
+    float antialiasThreshold = 0.1f;
+    // Stationary float views keep adding jittered samples per pixel up to accumulateFrames
+    // (TemporalAccumulation); any view or coloring change starts over. With antialias on the
+    // mean starts from the anti-aliased frame, refined pixels counting all their subsamples.
+    bool accumulate = false;
+    int accumulateFrames = 64;
+    // Palette cycling advances paletteOffset by cycleSpeed iterations per second
+    bool paletteCycle = false;
+    float cycleSpeed = 4.0f;
+    bool interiorChecks = true;
+    int periodCheck = 16;
+    bool idleWait = true;
+    bool playAnimation = false;
+    float animationTime = 0.0f;
+    float animationSpeed = 1.0f;
+
+    /// <summary>
+    /// Clamp the iteration limit and bailout radius to the supported range
+    /// </summary>
+    void ClampIterations()
+    {
+        maxIter = maxIter < minMaxIter ? minMaxIter : (maxIter > maxMaxIter ? maxMaxIter : maxIter);
+        bailout = bailout < minBailout ? minBailout : (bailout > maxBailout ? maxBailout : bailout);
+    }
+
+    /// <summary>
+    /// Clamp the coloring settings to the supported range
+    /// </summary>
+    void ClampColoring()
+    {
+        paletteDensity = paletteDensity < minPaletteDensity ? minPaletteDensity : (paletteDensity > maxPaletteDensity ? maxPaletteDensity : paletteDensity);
+        exposure = exposure < 0.0f ? 0.0f : (exposure > maxExposure ? maxExposure : exposure);
+        boundaryWidth = boundaryWidth < 0.0f ? 0.0f : (boundaryWidth > maxBoundaryWidth ? maxBoundaryWidth : boundaryWidth);
+        antialiasThreshold = antialiasThreshold < 0.0f ? 0.0f :
+            (antialiasThreshold > maxAntialiasThreshold ? maxAntialiasThreshold : antialiasThreshold);
+        accumulateFrames = accumulateFrames < 1 ? 1 : (accumulateFrames > maxAccumulateFrames ? maxAccumulateFrames : accumulateFrames);
+    }
+
+    void Reset()
+    {
+        dx = 0;
+        dy = 0;
+        scale = 1.0;
+        maxIter = 1000;
+        bailout = 256.0;
+        filterOn = false;
+        deepZoom = false;
+        autoPrecision = true;
+        progressive = false;
+        reproject = true;
+        mariani = false;
+        dynamicResolution = false;
+        frameBudget = 16.0f;
+        histogram = false;
+        distanceEstimate = false;
+        antialias = false;
+        paletteOffset = 0.0f;
+        paletteDensity = 1.0f;
+        exposure = 1.0f;
+        boundaryWidth = 1.0f;
+        antialiasThreshold = 0.1f;
+        accumulate = false;
+        accumulateFrames = 64;
+        paletteCycle = false;
+        cycleSpeed = 4.0f;
+        interiorChecks = true;
+        periodCheck = 16;
+        idleWait = true;
+        playAnimation = false;
+        animationTime = 0.0f;
+        animationSpeed = 1.0f;
+    }
+
+    /// <summary>
+    /// Value of the periodCheck kernel argument, negative when the interior checks are off
+    /// </summary>
+    inline int GetPeriodCheck() const { return interiorChecks ? periodCheck : -1; }
+
+    /// <summary>
+    /// Whether two parameter sets produce the same samples, see SameColoring for the pixels
+    /// </summary>
+    bool SameView(const Params& other) const
+    {
+        return dx == other.dx && dy == other.dy && scale == other.scale &&
+            maxIter == other.maxIter && bailout == other.bailout && filterOn == other.filterOn && deepZoom == other.deepZoom &&
+            autoPrecision == other.autoPrecision && mariani == other.mariani && histogram == other.histogram &&
+            distanceEstimate == other.distanceEstimate && antialias == other.antialias;
+    }
+
+    /// <summary>
+    /// Whether two parameter sets with the same view also color it the same
+    /// </summary>
+    bool SameColoring(const Params& other) const
+    {
+        return paletteOffset == other.paletteOffset && paletteDensity == other.paletteDensity && exposure == other.exposure &&
+            boundaryWidth == other.boundaryWidth && antialiasThreshold == other.antialiasThreshold && accumulate == other.accumulate;
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <CL/cl.hpp>
+#include <map>
+#include <string>
+
+/// <summary>
+/// Builds mandel.cl specialized for an iteration limit and bailout radius (-D MAX_ITER and
+/// -D BAILOUT), so the loop bound stays a compile time constant, and keeps every built
+/// variant so switching back to a previous configuration costs nothing.
+/// Built binaries are also saved next to the executable, keyed by device, driver version,
+/// build options and source hash, and loaded instead of compiling on later runs.
+/// </summary>
+class ProgramCache
+{
+public:
+    ProgramCache();
+
+    /// <summary>
+    /// Set the context, device and kernel source to build from
+    /// </summary>
+    void Init(const cl::Context& context, const cl::Device& device, const std::string& source);
+
+    /// <summary>
+    /// Get the program for a configuration, building it on first use
+    /// </summary>
+    /// <param name="maxIter">Iteration limit</param>
+    /// <param name="bailout">Escape radius</param>
+    /// <returns>Built program, NULL if the build failed</returns>
+    const cl::Program* Get(int maxIter, double bailout);
+
+    /// <summary>
+    /// Compiler options for a configuration
+    /// </summary>
+    static std::string GetBuildOptions(int maxIter, double bailout);
+
+    inline size_t GetProgramCount() const { return m_programs.size(); }
+
+    /// <summary>
+    /// Number of programs that were loaded from the binary cache instead of compiled
+    /// </summary>
+    inline int GetBinaryHits() const { return m_binaryHits; }
+
+private:
+    /// <summary>
+    /// Unique description of a build: everything that makes a device binary reusable
+    /// </summary>
+    std::string GetCacheKey(const std::string& options) const;
+
+    /// <summary>
+    /// Load and build a cached binary, fails if there is none or its key does not match
+    /// </summary>
+    bool LoadBinary(const std::string& key, const std::string& options, cl::Program& program) const;
+
+    /// <summary>
+    /// Save the binary of a built program for the key
+    /// </summary>
+    void SaveBinary(const std::string& key, const cl::Program& program) const;
+
+    cl::Context m_context;
+    cl::Device m_device;
+    std::string m_source;
+    std::map<std::string, cl::Program> m_programs;
+    int m_binaryHits;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Params.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Sample grid of one render pass: every step-th pixel is computed and fills its
+/// step x step block. Samples on the prevStep grid are reused from the sample buffer.
+/// </summary>
+struct RenderPass {
+    int step = 1;
+    int prevStep = 0;
+    // Band of rows [rowBegin, rowEnd) to render, rowEnd 0 for the whole image. rowBegin
+    // must be a multiple of step.
+    int rowBegin = 0;
+    int rowEnd = 0;
+
+    /// <summary>
+    /// Global offset of the band
+    /// </summary>
+    inline cl::NDRange GetOffset() const
+    {
+        return cl::NDRange(0, rowBegin / step);
+    }
+
+    /// <summary>
+    /// NDRange covering the pass' sample grid within the band
+    /// </summary>
+    inline cl::NDRange GetGlobal(int width, int height) const
+    {
+        const int end = rowEnd > 0 ? rowEnd : height;
+        return cl::NDRange((width + step - 1) / step, (end + step - 1) / step - rowBegin / step);
+    }
+};
+
+/// <summary>
+/// Coarse-to-fine scheduler: renders a view at 1/16, 1/4 and then full resolution,
+/// one pass per frame, restarting from the coarsest pass whenever the view changes
+/// </summary>
+class ProgressiveRenderer
+{
+public:
+    ProgressiveRenderer();
+
+    /// <summary>
+    /// Get the next pass for the view
+    /// </summary>
+    /// <param name="params">Current view parameters</param>
+    /// <param name="pass">Filled with the pass to render</param>
+    /// <returns>false once the view is fully refined and nothing is left to render</returns>
+    bool NextPass(const Params& params, RenderPass& pass);
+
+    /// <summary>
+    /// Force the next call to start over from the coarsest pass
+    /// </summary>
+    inline void Restart() { m_started = false; }
+
+    /// <summary>
+    /// Mark a view as fully refined (e.g. after it was reprojected at full resolution)
+    /// </summary>
+    void Complete(const Params& params);
+
+    inline int GetPass() const { return m_pass; }
+    inline int GetPassCount() const { return passCount; }
+
+private:
+    static const int passCount = 3;
+    static const int steps[passCount];
+
+    Params m_lastParams;
+    int m_pass;
+    bool m_started;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+/// <summary>
+/// Follows the window's framebuffer size for the render targets. A new size only applies
+/// once it has held for a short settle time, so dragging a window edge reallocates the
+/// targets once at the end of the drag instead of every frame; meanwhile the last frame is
+/// stretched over the window. Zero sizes (minimized windows) are ignored.
+/// </summary>
+class RenderTargets
+{
+public:
+    RenderTargets();
+
+    /// <summary>
+    /// Start at the size the render targets were created with
+    /// </summary>
+    void Init(int width, int height);
+
+    /// <summary>
+    /// Track the framebuffer size
+    /// </summary>
+    /// <param name="time">Current time in seconds</param>
+    /// <returns>true when the render targets have to change to GetWidth() x GetHeight()</returns>
+    bool Update(int framebufferWidth, int framebufferHeight, double time);
+
+    /// <summary>
+    /// Whether a size change is waiting to settle, the loop must keep polling to apply it
+    /// </summary>
+    inline bool IsPending() const { return m_pendingWidth != m_width || m_pendingHeight != m_height; }
+
+    inline int GetWidth() const { return m_width; }
+    inline int GetHeight() const { return m_height; }
+
+    /// <summary>
+    /// Seconds a new size has to hold before it applies
+    /// </summary>
+    static double GetSettleTime();
+
+private:
+    int m_width;
+    int m_height;
+    int m_pendingWidth;
+    int m_pendingHeight;
+    // When the pending size was first seen
+    double m_changeTime;
+};
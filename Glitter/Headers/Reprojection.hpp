@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Params.hpp"
+#include "MandelVariants.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Pan reprojection cache. Holds the per-pixel sample buffer (iter, final z) of the last
+/// fully rendered view, and its distance estimates when the view has them; when the next
+/// view only differs by an offset, both are shifted on the device and only the newly
+/// exposed pixels are iterated again.
+/// </summary>
+class ReprojectionCache
+{
+public:
+    ReprojectionCache();
+
+    /// <summary>
+    /// Create the double-buffered sample and distance storage and the reprojection kernels
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Program& program, int width, int height);
+
+    /// <summary>
+    /// Change the frame size and drop the cached view. Storage only grows, a smaller frame
+    /// keeps using the buffers it fits in.
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Resize(int width, int height);
+
+    /// <summary>
+    /// Check whether the cached samples can be reused for a view. Pans are snapped to whole
+    /// pixels of the cached view (adjusting params.dx/dy by less than half a pixel).
+    /// </summary>
+    /// <param name="params">New view, offset may be snapped</param>
+    /// <param name="precision">Arithmetic the new view will be rendered with</param>
+    /// <param name="shiftX">Pixel shift from the cached view</param>
+    /// <param name="shiftY">Pixel shift from the cached view</param>
+    /// <returns>true if the view can be rendered as a reprojection pass</returns>
+    bool Prepare(Params& params, Precision precision, int& shiftX, int& shiftY) const;
+
+    /// <summary>
+    /// Shift the cached samples (and distances) into the other buffer and make it current
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Reproject(const cl::CommandQueue& queue, int shiftX, int shiftY);
+
+    /// <summary>
+    /// Record that the current samples hold a complete render of a view
+    /// </summary>
+    void Store(const Params& params, Precision precision);
+
+    /// <summary>
+    /// Current samples no longer match a complete view
+    /// </summary>
+    inline void Invalidate() { m_valid = false; }
+
+    inline const cl::Buffer& GetSamples() const { return m_samples[m_current]; }
+
+    /// <summary>
+    /// Distance estimates laid out like the samples, see MandelVariants::RenderDistance
+    /// </summary>
+    inline const cl::Buffer& GetDistance() const { return m_distance[m_current]; }
+
+private:
+    int m_width;
+    int m_height;
+    // Pixels the buffers hold
+    size_t m_capacity;
+    cl::Context m_context;
+    cl::Kernel m_kernel;
+    cl::Kernel m_distanceKernel;
+    cl::Buffer m_samples[2];
+    cl::Buffer m_distance[2];
+    int m_current;
+
+    bool m_valid;
+    Params m_cachedParams;
+    Precision m_cachedPrecision;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Dynamic resolution for interaction: picks the sample grid step of frames rendered while
+/// the view moves so the iteration kernel fits a frame time budget. Kernel times come from
+/// profiling events of earlier frames and are turned into a cost per sample, which predicts
+/// the time of every step (a step s frame iterates 1/s^2 of the pixels). The coarse frame is
+/// upsampled by the coloring pass; once the view stands still, a step 1 pass reusing the
+/// coarse samples completes it.
+/// </summary>
+class ResolutionController
+{
+public:
+    ResolutionController();
+
+    /// <summary>
+    /// Frame size the steps are predicted for
+    /// </summary>
+    void Init(int width, int height);
+
+    /// <summary>
+    /// Time the kernel of a pass iterating every step-th sample of the frame, once its event completes.
+    /// The queue must have profiling enabled.
+    /// </summary>
+    void Submit(const cl::Event& event, int step);
+
+    /// <summary>
+    /// Take over a completed measurement, if any, and pick the step of the next interactive frame
+    /// </summary>
+    /// <param name="targetMs">Kernel time budget per frame in milliseconds</param>
+    void Update(float targetMs);
+
+    /// <summary>
+    /// Sample grid step of the next interactive frame, 1 for full resolution
+    /// </summary>
+    inline int GetStep() const { return m_step; }
+
+    /// <summary>
+    /// Kernel time of the last measured frame in milliseconds
+    /// </summary>
+    inline float GetKernelTime() const { return m_kernelTime; }
+
+private:
+    static const int maxStep = 8;
+
+    /// <summary>
+    /// Samples a pass with the step iterates
+    /// </summary>
+    double GetSamples(int step) const;
+
+    int m_width;
+    int m_height;
+    int m_step;
+    // Smoothed kernel time per sample in milliseconds, 0 until measured
+    double m_costPerSample;
+    float m_kernelTime;
+
+    cl::Event m_event;
+    int m_eventStep;
+    bool m_pending;
+};
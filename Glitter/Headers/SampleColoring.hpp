@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Params.hpp"
+#include "Palette.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Coloring pass of the smooth renderers: maps the (iter, |z|^2) sample buffer to pixels with a
+/// runtime palette, so palette edits, cycling and exposure changes never iterate again.
+/// Also owns the palette LUT image HistogramColoring reads.
+/// </summary>
+class SampleColoring
+{
+public:
+    SampleColoring();
+
+    /// <summary>
+    /// Create the kernel and upload the default palette
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Program& program, int width, int height);
+
+    /// <summary>
+    /// Recreate the kernel from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Change the frame size, the image may be larger than the frame
+    /// </summary>
+    void Resize(int width, int height);
+
+    /// <summary>
+    /// Bake a palette into the LUT image
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetPalette(const Palette& palette);
+
+    /// <summary>
+    /// Color the samples into the image
+    /// </summary>
+    /// <param name="step">Step of the last progressive pass, each valid sample colors its step x step block</param>
+    /// <param name="params">Palette offset, density, exposure and boundary width</param>
+    /// <param name="rowBegin">First row to color</param>
+    /// <param name="rowEnd">Row after the last one to color, negative for the full height</param>
+    /// <param name="distance">Distance estimates of the samples (MandelSmoothDE), NULL for no boundary shading</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer& samples, int step, const Params& params,
+        int rowBegin = 0, int rowEnd = -1, const cl::Buffer* distance = NULL);
+
+    inline const cl::Image1D& GetPalette() const { return m_palette; }
+
+    /// <summary>
+    /// Iterations one palette cycle spans at palette density 1
+    /// </summary>
+    inline float GetPeriod() const { return m_period; }
+
+    /// <summary>
+    /// One-float buffer bound in place of a distance buffer when there is none
+    /// </summary>
+    inline const cl::Buffer& GetNoDistance() const { return m_noDistance; }
+
+private:
+    cl::Context m_context;
+    cl::Kernel m_kernel;
+    cl::Image1D m_palette;
+    cl::Buffer m_noDistance;
+    float m_period;
+    int m_width;
+    int m_height;
+};
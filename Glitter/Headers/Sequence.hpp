@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Params.hpp"
+#include "Options.hpp"
+#include "Palette.hpp"
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// View at a point in time of a zoom sequence
+/// </summary>
+struct Keyframe {
+    double time = 0.0;
+    double dx = 0.0;
+    double dy = 0.0;
+    double scale = 1.0;
+};
+
+/// <summary>
+/// Keyframed zoom path. Between keyframes the scale changes exponentially (constant zoom
+/// speed) and the center moves so it travels in a straight line on screen instead of
+/// rushing past at high zoom.
+/// </summary>
+class ZoomPath
+{
+public:
+    /// <summary>
+    /// Load keyframes from a text file, one "time dx dy scale" line each, # for comments
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Load(const std::string& path);
+
+    /// <summary>
+    /// Append a keyframe, later than the last one
+    /// </summary>
+    /// <returns>false if the keyframe is not later</returns>
+    bool Add(const Keyframe& keyframe);
+
+    /// <summary>
+    /// View parameters at a time, other settings taken from base
+    /// </summary>
+    Params Evaluate(double time, const Params& base) const;
+
+    inline double GetDuration() const { return m_keyframes.empty() ? 0.0 : m_keyframes.back().time; }
+    inline size_t GetKeyframeCount() const { return m_keyframes.size(); }
+
+private:
+    std::vector<Keyframe> m_keyframes;
+};
+
+/// <summary>
+/// Writes rendered frames on background threads so rendering the next frame overlaps with
+/// encoding and disk I/O of the previous ones. PNG frames are encoded by several writers in
+/// any order; a Y4M stream (4:2:0, for ffmpeg and other encoders, also through a named pipe)
+/// is written by one writer in frame order. Frame buffers come from a small pool, so the
+/// renderer blocks when it runs too far ahead of the writers.
+/// </summary>
+class FrameWriter
+{
+public:
+    FrameWriter(int width, int height);
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    /// <summary>
+    /// Start the writers
+    /// </summary>
+    /// <param name="output">A .y4m stream, or a PNG path with a printf frame number pattern such as frame_%05d.png</param>
+    /// <param name="fps">Frame rate written to the Y4M header</param>
+    /// <param name="writerCount">PNG writer threads, 0 for all cores but one</param>
+    /// <returns>true on success</returns>
+    bool Open(const std::string& output, int fps, int writerCount = 0);
+
+    /// <summary>
+    /// Get a free RGBA8 frame buffer, waiting for a writer to release one
+    /// </summary>
+    std::vector<unsigned char>* Acquire();
+
+    /// <summary>
+    /// Queue a filled buffer from Acquire for writing
+    /// </summary>
+    void Submit(int frame, std::vector<unsigned char>* pixels);
+
+    /// <summary>
+    /// Write all queued frames and stop the writers
+    /// </summary>
+    /// <returns>false if any frame failed to write</returns>
+    bool Close();
+
+    /// <summary>
+    /// Seconds the renderer spent waiting for a free buffer
+    /// </summary>
+    inline double GetStallTime() const { return m_stallTime; }
+
+private:
+    struct Job {
+        int frame;
+        std::vector<unsigned char>* pixels;
+    };
+
+    void WriterLoop();
+    bool WritePngFrame(const Job& job) const;
+    bool WriteY4mFrame(const Job& job);
+
+    int m_width;
+    int m_height;
+    std::string m_output;
+    bool m_y4m;
+    FILE* m_stream;
+    // Y4M planes, reused by the single stream writer
+    std::vector<unsigned char> m_planes;
+
+    std::vector<std::unique_ptr<std::vector<unsigned char>>> m_buffers;
+    std::vector<std::vector<unsigned char>*> m_free;
+    std::deque<Job> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_jobReady;
+    std::condition_variable m_bufferFree;
+    std::vector<std::thread> m_writers;
+    bool m_closing;
+    bool m_failed;
+    double m_stallTime;
+};
+
+/// <summary>
+/// Render options.sequence: every frame of the zoom path headless (OpenCL, or the CPU
+/// backend without a usable device) with the given palette into the frame writer
+/// </summary>
+/// <returns>true on success</returns>
+bool RunSequence(const Options& options, const Palette& palette);
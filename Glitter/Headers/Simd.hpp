@@ -0,0 +1,175 @@
+#pragma once
+
+// Thin wrappers over the float vector instruction sets used by the CPU kernels. Each wrapper
+// is only defined when the translation unit is compiled for its instruction set, see the
+// CpuKernels*.cpp files and the per-file flags in CMakeLists.txt.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/// <summary>
+/// One lane, the reference all vector widths must agree with
+/// </summary>
+struct SimdScalar
+{
+    typedef float Float;
+    typedef bool Mask;
+    static const int width = 1;
+
+    static inline const char* Name() { return "scalar"; }
+    static inline Float Set(float value) { return value; }
+    static inline Float Load(const float* data) { return *data; }
+    static inline void Store(float* data, Float value) { *data = value; }
+    static inline Float Add(Float a, Float b) { return a + b; }
+    static inline Float Sub(Float a, Float b) { return a - b; }
+    static inline Float Mul(Float a, Float b) { return a * b; }
+    static inline Mask LessEqual(Float a, Float b) { return a <= b; }
+    static inline Mask Equal(Float a, Float b) { return a == b; }
+    static inline Mask And(Mask a, Mask b) { return a && b; }
+    static inline Mask AndNot(Mask a, Mask b) { return a && !b; }
+    static inline Mask Or(Mask a, Mask b) { return a || b; }
+    static inline Mask True() { return true; }
+    static inline Float Select(Mask mask, Float a, Float b) { return mask ? a : b; }
+    static inline bool Any(Mask mask) { return mask; }
+    static inline int Count(Mask mask) { return mask ? 1 : 0; }
+};
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+/// <summary>
+/// 4 lanes, baseline of every x86-64 CPU
+/// </summary>
+struct SimdSSE2
+{
+    typedef __m128 Float;
+    typedef __m128 Mask;
+    static const int width = 4;
+
+    static inline const char* Name() { return "sse2"; }
+    static inline Float Set(float value) { return _mm_set1_ps(value); }
+    static inline Float Load(const float* data) { return _mm_loadu_ps(data); }
+    static inline void Store(float* data, Float value) { _mm_storeu_ps(data, value); }
+    static inline Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static inline Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+    static inline Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static inline Mask LessEqual(Float a, Float b) { return _mm_cmple_ps(a, b); }
+    static inline Mask Equal(Float a, Float b) { return _mm_cmpeq_ps(a, b); }
+    static inline Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+    static inline Mask AndNot(Mask a, Mask b) { return _mm_andnot_ps(b, a); }
+    static inline Mask Or(Mask a, Mask b) { return _mm_or_ps(a, b); }
+    static inline Mask True() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+    static inline Float Select(Mask mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static inline bool Any(Mask mask) { return _mm_movemask_ps(mask) != 0; }
+    static inline int Count(Mask mask)
+    {
+        const int bits = _mm_movemask_ps(mask);
+        return (bits & 1) + ((bits >> 1) & 1) + ((bits >> 2) & 1) + ((bits >> 3) & 1);
+    }
+};
+#endif
+
+#if defined(__AVX2__)
+/// <summary>
+/// 8 lanes
+/// </summary>
+struct SimdAVX2
+{
+    typedef __m256 Float;
+    typedef __m256 Mask;
+    static const int width = 8;
+
+    static inline const char* Name() { return "avx2"; }
+    static inline Float Set(float value) { return _mm256_set1_ps(value); }
+    static inline Float Load(const float* data) { return _mm256_loadu_ps(data); }
+    static inline void Store(float* data, Float value) { _mm256_storeu_ps(data, value); }
+    static inline Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static inline Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+    static inline Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static inline Mask LessEqual(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static inline Mask Equal(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static inline Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+    static inline Mask AndNot(Mask a, Mask b) { return _mm256_andnot_ps(b, a); }
+    static inline Mask Or(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+    static inline Mask True() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+    static inline Float Select(Mask mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+    static inline bool Any(Mask mask) { return _mm256_movemask_ps(mask) != 0; }
+    static inline int Count(Mask mask)
+    {
+        int bits = _mm256_movemask_ps(mask);
+        int count = 0;
+        for (; bits != 0; bits &= bits - 1)
+            count++;
+        return count;
+    }
+};
+#endif
+
+#if defined(__AVX512F__)
+/// <summary>
+/// 16 lanes, masks live in the k registers
+/// </summary>
+struct SimdAVX512
+{
+    typedef __m512 Float;
+    typedef __mmask16 Mask;
+    static const int width = 16;
+
+    static inline const char* Name() { return "avx512"; }
+    static inline Float Set(float value) { return _mm512_set1_ps(value); }
+    static inline Float Load(const float* data) { return _mm512_loadu_ps(data); }
+    static inline void Store(float* data, Float value) { _mm512_storeu_ps(data, value); }
+    static inline Float Add(Float a, Float b) { return _mm512_add_ps(a, b); }
+    static inline Float Sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+    static inline Float Mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+    static inline Mask LessEqual(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+    static inline Mask Equal(Float a, Float b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static inline Mask And(Mask a, Mask b) { return (Mask)(a & b); }
+    static inline Mask AndNot(Mask a, Mask b) { return (Mask)(a & ~b); }
+    static inline Mask Or(Mask a, Mask b) { return (Mask)(a | b); }
+    static inline Mask True() { return (Mask)0xFFFF; }
+    static inline Float Select(Mask mask, Float a, Float b) { return _mm512_mask_blend_ps(mask, b, a); }
+    static inline bool Any(Mask mask) { return mask != 0; }
+    static inline int Count(Mask mask)
+    {
+        int count = 0;
+        for (unsigned int bits = mask; bits != 0; bits &= bits - 1)
+            count++;
+        return count;
+    }
+};
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+/// <summary>
+/// 4 lanes on AArch64
+/// </summary>
+struct SimdNEON
+{
+    typedef float32x4_t Float;
+    typedef uint32x4_t Mask;
+    static const int width = 4;
+
+    static inline const char* Name() { return "neon"; }
+    static inline Float Set(float value) { return vdupq_n_f32(value); }
+    static inline Float Load(const float* data) { return vld1q_f32(data); }
+    static inline void Store(float* data, Float value) { vst1q_f32(data, value); }
+    static inline Float Add(Float a, Float b) { return vaddq_f32(a, b); }
+    static inline Float Sub(Float a, Float b) { return vsubq_f32(a, b); }
+    static inline Float Mul(Float a, Float b) { return vmulq_f32(a, b); }
+    static inline Mask LessEqual(Float a, Float b) { return vcleq_f32(a, b); }
+    static inline Mask Equal(Float a, Float b) { return vceqq_f32(a, b); }
+    static inline Mask And(Mask a, Mask b) { return vandq_u32(a, b); }
+    static inline Mask AndNot(Mask a, Mask b) { return vbicq_u32(a, b); }
+    static inline Mask Or(Mask a, Mask b) { return vorrq_u32(a, b); }
+    static inline Mask True() { return vdupq_n_u32(0xFFFFFFFFu); }
+    static inline Float Select(Mask mask, Float a, Float b) { return vbslq_f32(mask, a, b); }
+    static inline bool Any(Mask mask) { return vmaxvq_u32(mask) != 0; }
+    static inline int Count(Mask mask) { return (int)vaddvq_u32(vshrq_n_u32(mask, 31)); }
+};
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Params.hpp"
+#include "SampleColoring.hpp"
+#include <CL/cl.hpp>
+
+/// <summary>
+/// Progressive anti-aliasing of a stationary float view: each Render iterates every pixel
+/// once more at a new sub-pixel jitter and blends the color into a running mean kept on the
+/// device, so frames that would repeat the same image converge to a supersampled one.
+/// The regular single-sample frame counts as the first sample; Reset starts over from it.
+/// </summary>
+class TemporalAccumulation
+{
+public:
+    TemporalAccumulation();
+
+    /// <summary>
+    /// Create the kernels and the accumulation buffer
+    /// </summary>
+    /// <param name="earlyExits">IterationStats counter buffer</param>
+    /// <returns>true on success</returns>
+    bool Init(const cl::Context& context, const cl::Program& program, int width, int height, const cl::Buffer& earlyExits);
+
+    /// <summary>
+    /// Recreate the kernels from another build of the program (see ProgramCache)
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool SetProgram(const cl::Program& program);
+
+    /// <summary>
+    /// Change the frame size and drop the accumulated samples, growing the buffer if it is too small
+    /// </summary>
+    /// <returns>true on success</returns>
+    bool Resize(int width, int height);
+
+    /// <summary>
+    /// Drop the accumulated samples, the frame just colored from the sample buffer is the first one
+    /// </summary>
+    inline void Reset() { m_frames = 1; }
+
+    /// <summary>
+    /// Start the mean from the colors of a complete float sample buffer, as the coloring pass
+    /// shows them. Anti-aliasing run afterwards replaces the pixels it refines (see GetBuffer).
+    /// </summary>
+    /// <param name="coloring">Owner of the palette LUT</param>
+    /// <returns>true on success</returns>
+    bool Seed(const cl::CommandQueue& queue, const cl::Buffer& samples, const SampleColoring& coloring, const Params& params);
+
+    /// <summary>
+    /// Add one jittered sample per pixel to the mean started by Seed and write the mean into the image
+    /// </summary>
+    /// <param name="distance">Distance estimates of the samples, NULL for no boundary shading</param>
+    /// <param name="coloring">Owner of the palette LUT</param>
+    /// <returns>true on success</returns>
+    bool Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer* distance,
+        const SampleColoring& coloring, const Params& params);
+
+    /// <summary>
+    /// Frames in the mean; pixels refined by anti-aliasing also count their subsamples
+    /// </summary>
+    inline int GetFrames() const { return m_frames; }
+
+    /// <summary>
+    /// Per-pixel mean, unshaded color and sample count (AdaptiveSampling stores refined pixels here)
+    /// </summary>
+    inline const cl::Buffer& GetBuffer() const { return m_accum; }
+
+private:
+    cl::Context m_context;
+    cl::Kernel m_seedKernel;
+    cl::Kernel m_kernel;
+    cl::Buffer m_accum;
+    cl::Buffer m_earlyExits;
+    int m_width;
+    int m_height;
+    // Pixels the accumulation buffer holds
+    size_t m_capacity;
+    int m_frames;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Persistent thread pool that runs a frame's tiles with work stealing. Tiles are dealt
+/// round robin onto per-thread deques, most expensive first when costs of the previous frame
+/// are known. A thread pops from the front of its own deque and, once that is empty, steals
+/// from the back of the others, so interior-heavy regions spread over all cores.
+/// </summary>
+class TileScheduler
+{
+public:
+    /// <param name="threadCount">Worker count including the calling thread, 0 for all cores</param>
+    explicit TileScheduler(int threadCount = 0);
+    ~TileScheduler();
+
+    TileScheduler(const TileScheduler&) = delete;
+    TileScheduler& operator=(const TileScheduler&) = delete;
+
+    /// <summary>
+    /// Run task(tile, worker) for every tile in [0, tileCount) and wait for all of them.
+    /// The calling thread works as worker 0.
+    /// </summary>
+    /// <param name="costs">Optional per-tile seconds: orders the tiles when it has tileCount
+    /// entries and receives the measured times afterwards</param>
+    void Run(int tileCount, const std::function<void(int, int)>& task, std::vector<double>* costs = NULL);
+
+    inline int GetThreadCount() const { return m_threadCount; }
+
+    /// <summary>
+    /// Tiles taken from another thread's deque during the last Run
+    /// </summary>
+    inline long long GetSteals() const { return m_steals; }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<int> tiles;
+    };
+
+    void WorkerLoop(int worker);
+
+    /// <summary>
+    /// Process tiles until every deque is empty
+    /// </summary>
+    void Work(int worker);
+
+    bool Pop(int worker, int& tile);
+    bool Steal(int worker, int& tile);
+
+    int m_threadCount;
+    std::vector<std::thread> m_threads;
+    std::unique_ptr<WorkerQueue[]> m_queues;
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    unsigned int m_generation;
+    int m_busy;
+    bool m_quit;
+
+    const std::function<void(int, int)>* m_task;
+    std::vector<double>* m_costs;
+    std::atomic<long long> m_steals;
+};
@@ -14,33 +14,32 @@
 #include <iostream>
 #include <Timer.hpp>
 #include <GUI.hpp>
+#include <Params.hpp>
+#include <Options.hpp>
+#include <CLHelpers.hpp>
+#include <DeepZoom.hpp>
+#include <MandelVariants.hpp>
+#include <Progressive.hpp>
+#include <Reprojection.hpp>
+#include <MarianiSilver.hpp>
+#include <IterationStats.hpp>
+#include <ProgramCache.hpp>
+#include <FramePipeline.hpp>
+#include <MultiDevice.hpp>
+#include <DeviceSelection.hpp>
+#include <HistogramColoring.hpp>
+#include <SampleColoring.hpp>
+#include <AdaptiveSampling.hpp>
+#include <TemporalAccumulation.hpp>
+#include <ResolutionController.hpp>
+#include <RenderTargets.hpp>
+#include <Palette.hpp>
 
 // Reference: https://github.com/nothings/stb/blob/master/stb_image.h#L4
 // To use stb_image, add this in *one* C++ source file.
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-struct Params {
-    float dx = 0;
-    float dy = 0;
-    float scale = 1.0f;
-    bool filterOn = false;
-    bool playAnimation = false;
-    float animationTime = 0.0f;
-    float animationSpeed = 1.0f;
-
-    void Reset()
-    {
-        dx = 0;
-        dy = 0;
-        scale = 1.0f;
-        filterOn = false;
-        playAnimation = false;
-        animationTime = 0.0f;
-        animationSpeed = 1.0f;
-    }
-};
-
 // Define Some Constants
 int mWidth = 1920;
 int mHeight = 1080;
@@ -56,6 +55,7 @@ std::string kernel_source;
 cl::Program::Sources sources;
 cl::CommandQueue queue;
 cl::Program program;
+ProgramCache program_cache;
 cl::Buffer test_buffer;
 cl::Buffer debug_buffer;
 cl::Kernel test_kernel;
@@ -77,37 +77,22 @@ unsigned int indices[] = {
 };
 
 cl::make_kernel<cl::Image2D> tester(test_kernel);
-cl::make_kernel<cl::Image2D, float, float, float> mandeler(mandel_Kernel);
-cl::make_kernel<cl::Image2D, cl::Image2D> filter(filter_Kernel);
-
-cl::Image2D target_texture;
-cl::Image2D copy_texture;
+cl::make_kernel<cl::Image2D, cl::Image2D, cl_int2> filter(filter_Kernel);
 
-std::string ReadFile2(const char* f_name = "kernels.cl")
-{
-    std::string kernel_code;
-    std::ifstream kernel_file;
-    // ensure ifstream objects can throw exceptions:
-    kernel_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try
-    {
-        
-        kernel_file.open(f_name);
-        std::stringstream kernel_stream;
-        
-        kernel_stream << kernel_file.rdbuf();
-        
-        kernel_file.close();
-        
-        kernel_code = kernel_stream.str();
-    }
-    catch (std::ifstream::failure& e)
-    {
-        std::cout << "ERROR::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
-    }
+FramePipeline frame_pipeline;
+RenderTargets render_targets;
 
-    // return char sequence
-    return kernel_code.c_str();
-}
+DeepZoom deep_zoom;
+MandelVariants mandel_variants;
+ProgressiveRenderer progressive;
+ReprojectionCache reprojection;
+MarianiSilver mariani;
+IterationStats iteration_stats;
+MultiDevice multi_device(mWidth, mHeight);
+HistogramColoring histogram_coloring;
+SampleColoring sample_coloring;
+AdaptiveSampling adaptive_sampling;
+TemporalAccumulation temporal_accumulation;
+ResolutionController resolution_controller;
 
 #endif //~ Glitter Header
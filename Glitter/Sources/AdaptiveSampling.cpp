@@ -0,0 +1,163 @@
+#include "AdaptiveSampling.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+AdaptiveSampling::AdaptiveSampling()
+    :
+    m_width(0),
+    m_height(0),
+    m_capacity(0),
+    m_refineItems(1),
+    m_refined(0),
+    m_readback(0),
+    m_readPending(false)
+{
+}
+
+bool AdaptiveSampling::Init(const cl::Context& context, const cl::Program& program, int width, int height, const cl::Buffer& earlyExits)
+{
+    m_context = context;
+    m_earlyExits = earlyExits;
+
+    cl_int err = CL_SUCCESS;
+    m_count = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_int), NULL, &err);
+    if (err == CL_SUCCESS)
+        m_noResolved = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_float4), NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating adaptive sampling buffers" << " " << err << "\n";
+        return false;
+    }
+
+    return Resize(width, height) && SetProgram(program);
+}
+
+bool AdaptiveSampling::Resize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+
+    // Enough work items to refine a quarter of the frame in one stride, typical frames
+    // refine far fewer pixels and the idle items return at once
+    m_refineItems = std::max((width * height / 4 + 63) / 64 * 64, 64);
+
+    const size_t pixels = (size_t)width * height;
+    if (pixels <= m_capacity)
+        return true;
+
+    cl_int err = CL_SUCCESS;
+    m_list = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(cl_int) * pixels, NULL, &err);
+    if (err != CL_SUCCESS) {
+        m_capacity = 0;
+        std::cout << "Error creating adaptive sampling list" << " " << err << "\n";
+        return false;
+    }
+    m_capacity = pixels;
+
+    // Kernels are created after the first list, later lists replace their argument
+    if (m_detectKernel() != NULL)
+    {
+        m_detectKernel.setArg(9, m_list);
+        m_refineKernel.setArg(4, m_list);
+    }
+
+    return true;
+}
+
+bool AdaptiveSampling::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_detectKernel = cl::Kernel(program, "AdaptiveDetect", &err);
+    if (err == CL_SUCCESS)
+        m_refineKernel = cl::Kernel(program, "AdaptiveRefine", &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating adaptive sampling kernels" << " " << err << "\n";
+        return false;
+    }
+
+    m_detectKernel.setArg(9, m_list);
+    m_detectKernel.setArg(10, m_count);
+    m_refineKernel.setArg(4, m_list);
+    m_refineKernel.setArg(5, m_count);
+    m_refineKernel.setArg(9, m_earlyExits);
+
+    return true;
+}
+
+bool AdaptiveSampling::Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer& samples, const cl::Buffer* distance,
+    const SampleColoring& coloring, const Params& params, cl_uint seed, const cl::Buffer* resolved)
+{
+    cl_int2 size;
+    size.s[0] = m_width;
+    size.s[1] = m_height;
+
+    // Same palette arguments as SampleColoring, so the detector sees the pixels on screen
+    const cl_float paletteScale = params.paletteDensity / coloring.GetPeriod();
+    const cl_float paletteOffset = params.paletteOffset / coloring.GetPeriod();
+    const bool shade = distance != NULL && params.distanceEstimate;
+    const cl::Buffer& shadeDistance = shade ? *distance : coloring.GetNoDistance();
+    const cl_float boundaryWidth = shade ? params.boundaryWidth : 0.0f;
+
+    const cl_int zero = 0;
+    cl_int err = queue.enqueueFillBuffer(m_count, zero, 0, sizeof(cl_int));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error resetting the refinement list" << " " << err << "\n";
+        return false;
+    }
+
+    m_detectKernel.setArg(0, size);
+    m_detectKernel.setArg(1, samples);
+    m_detectKernel.setArg(2, coloring.GetPalette());
+    m_detectKernel.setArg(3, paletteScale);
+    m_detectKernel.setArg(4, paletteOffset);
+    m_detectKernel.setArg(5, params.exposure);
+    m_detectKernel.setArg(6, shadeDistance);
+    m_detectKernel.setArg(7, boundaryWidth);
+    m_detectKernel.setArg(8, params.antialiasThreshold);
+    err = queue.enqueueNDRangeKernel(m_detectKernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing AdaptiveDetect" << " " << err << "\n";
+        return false;
+    }
+
+    m_refineKernel.setArg(0, size);
+    m_refineKernel.setArg(1, (cl_float)params.dx);
+    m_refineKernel.setArg(2, (cl_float)params.dy);
+    m_refineKernel.setArg(3, (cl_float)params.scale);
+    m_refineKernel.setArg(6, params.antialiasThreshold);
+    m_refineKernel.setArg(7, seed);
+    m_refineKernel.setArg(8, params.GetPeriodCheck());
+    m_refineKernel.setArg(10, coloring.GetPalette());
+    m_refineKernel.setArg(11, paletteScale);
+    m_refineKernel.setArg(12, paletteOffset);
+    m_refineKernel.setArg(13, params.exposure);
+    m_refineKernel.setArg(14, shadeDistance);
+    m_refineKernel.setArg(15, boundaryWidth);
+    m_refineKernel.setArg(16, image);
+    m_refineKernel.setArg(17, resolved != NULL ? *resolved : m_noResolved);
+    m_refineKernel.setArg(18, (cl_int)(resolved != NULL));
+    err = queue.enqueueNDRangeKernel(m_refineKernel, cl::NullRange, cl::NDRange(m_refineItems));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing AdaptiveRefine" << " " << err << "\n";
+        return false;
+    }
+
+    // The count lands with the frame, Update picks it up
+    err = queue.enqueueReadBuffer(m_count, CL_FALSE, 0, sizeof(cl_int), &m_readback, NULL, &m_readEvent);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error reading the refinement count" << " " << err << "\n";
+        return false;
+    }
+
+    m_readPending = true;
+    return true;
+}
+
+void AdaptiveSampling::Update()
+{
+    if (!m_readPending || m_readEvent.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE)
+        return;
+
+    m_refined = m_readback;
+    m_readPending = false;
+}
@@ -0,0 +1,228 @@
+#include "BigFixed.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+BigFixed::BigFixed(int limbs)
+    :
+    m_limbs(std::max(limbs, 2), 0u),
+    m_negative(false)
+{
+}
+
+BigFixed BigFixed::FromDouble(double value, int limbs)
+{
+    BigFixed res(limbs);
+    res.m_negative = value < 0.0;
+
+    double v = std::fabs(value);
+    double intPart = std::floor(v);
+    res.m_limbs.back() = (uint32_t)intPart;
+    v -= intPart;
+
+    // Peel off 32 fraction bits at a time, exact for a double mantissa
+    for (int i = res.GetLimbs() - 2; i >= 0 && v > 0.0; i--)
+    {
+        v *= 4294967296.0;
+        const double limb = std::floor(v);
+        res.m_limbs[i] = (uint32_t)limb;
+        v -= limb;
+    }
+
+    return res;
+}
+
+BigFixed BigFixed::FromString(const std::string& text, int limbs)
+{
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+'))
+        negative = text[pos++] == '-';
+
+    const size_t dot = text.find('.', pos);
+    const std::string intDigits = text.substr(pos, dot == std::string::npos ? std::string::npos : dot - pos);
+    const std::string fracDigits = dot == std::string::npos ? "" : text.substr(dot + 1);
+
+    // log2(10) ~ 3.33 bits per digit, plus a guard limb
+    if (limbs <= 0)
+        limbs = 2 + (int)(fracDigits.size() * 3.33 / 32.0) + 1;
+
+    BigFixed res(limbs);
+
+    // Horner on the fraction from the last digit: f = (f + d) / 10
+    for (size_t i = fracDigits.size(); i-- > 0;)
+    {
+        const char c = fracDigits[i];
+        if (c < '0' || c > '9')
+            continue;
+
+        res.m_limbs.back() += (uint32_t)(c - '0');
+        uint64_t rem = 0;
+        for (int j = res.GetLimbs() - 1; j >= 0; j--)
+        {
+            const uint64_t cur = (rem << 32) | res.m_limbs[j];
+            res.m_limbs[j] = (uint32_t)(cur / 10);
+            rem = cur % 10;
+        }
+    }
+
+    uint32_t intPart = 0;
+    for (const char c : intDigits)
+    {
+        if (c >= '0' && c <= '9')
+            intPart = intPart * 10 + (uint32_t)(c - '0');
+    }
+    res.m_limbs.back() = intPart;
+    res.m_negative = negative && !res.IsZero();
+
+    return res;
+}
+
+int BigFixed::LimbsForScale(double scale)
+{
+    // Pixel spacing is ~2.5 / (scale * width): log2(scale) + ~12 bits for the pixel grid,
+    // plus guard bits so the reference orbit stays accurate over many iterations
+    const double bits = std::log2(std::max(scale, 1.0)) + 64.0;
+    return 1 + (int)std::ceil(bits / 32.0);
+}
+
+double BigFixed::ToDouble() const
+{
+    double res = 0.0;
+    const int n = GetLimbs();
+    for (int i = n - 1; i >= 0; i--)
+        res += std::ldexp((double)m_limbs[i], 32 * (i - (n - 1)));
+
+    return m_negative ? -res : res;
+}
+
+BigFixed BigFixed::Resized(int limbs) const
+{
+    BigFixed res(limbs);
+    const int n = GetLimbs();
+    const int m = res.GetLimbs();
+    for (int i = 0; i < std::min(n, m); i++)
+        res.m_limbs[m - 1 - i] = m_limbs[n - 1 - i];
+
+    res.m_negative = m_negative && !res.IsZero();
+    return res;
+}
+
+BigFixed BigFixed::operator+(const BigFixed& other) const
+{
+    const int limbs = std::max(GetLimbs(), other.GetLimbs());
+    const BigFixed a = Resized(limbs);
+    const BigFixed b = other.Resized(limbs);
+    BigFixed res(limbs);
+
+    if (a.m_negative == b.m_negative)
+    {
+        AddMagnitude(a, b, res);
+        res.m_negative = a.m_negative;
+    }
+    else if (CompareMagnitude(a, b) >= 0)
+    {
+        SubMagnitude(a, b, res);
+        res.m_negative = a.m_negative;
+    }
+    else
+    {
+        SubMagnitude(b, a, res);
+        res.m_negative = b.m_negative;
+    }
+
+    res.m_negative = res.m_negative && !res.IsZero();
+    return res;
+}
+
+BigFixed BigFixed::operator-(const BigFixed& other) const
+{
+    BigFixed negated = other;
+    negated.m_negative = !other.m_negative && !other.IsZero();
+    return *this + negated;
+}
+
+BigFixed BigFixed::operator*(const BigFixed& other) const
+{
+    const int n = std::max(GetLimbs(), other.GetLimbs());
+    const BigFixed a = Resized(n);
+    const BigFixed b = other.Resized(n);
+
+    // Full 2n limb product, then drop the n - 1 lowest limbs to realign the fixed point
+    std::vector<uint32_t> product(2 * n, 0u);
+    for (int i = 0; i < n; i++)
+    {
+        if (a.m_limbs[i] == 0)
+            continue;
+
+        uint64_t carry = 0;
+        for (int j = 0; j < n; j++)
+        {
+            const uint64_t t = (uint64_t)a.m_limbs[i] * b.m_limbs[j] + product[i + j] + carry;
+            product[i + j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        product[i + n] = (uint32_t)carry;
+    }
+
+    BigFixed res(n);
+    for (int i = 0; i < n; i++)
+        res.m_limbs[i] = product[i + n - 1];
+
+    res.m_negative = (a.m_negative != b.m_negative) && !res.IsZero();
+    return res;
+}
+
+bool BigFixed::operator==(const BigFixed& other) const
+{
+    const int limbs = std::max(GetLimbs(), other.GetLimbs());
+    const BigFixed a = Resized(limbs);
+    const BigFixed b = other.Resized(limbs);
+    return a.m_negative == b.m_negative && a.m_limbs == b.m_limbs;
+}
+
+int BigFixed::CompareMagnitude(const BigFixed& a, const BigFixed& b)
+{
+    for (int i = a.GetLimbs() - 1; i >= 0; i--)
+    {
+        if (a.m_limbs[i] != b.m_limbs[i])
+            return a.m_limbs[i] > b.m_limbs[i] ? 1 : -1;
+    }
+
+    return 0;
+}
+
+void BigFixed::AddMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& res)
+{
+    uint64_t carry = 0;
+    for (int i = 0; i < a.GetLimbs(); i++)
+    {
+        const uint64_t t = (uint64_t)a.m_limbs[i] + b.m_limbs[i] + carry;
+        res.m_limbs[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+}
+
+void BigFixed::SubMagnitude(const BigFixed& a, const BigFixed& b, BigFixed& res)
+{
+    int64_t borrow = 0;
+    for (int i = 0; i < a.GetLimbs(); i++)
+    {
+        int64_t t = (int64_t)a.m_limbs[i] - b.m_limbs[i] - borrow;
+        borrow = t < 0 ? 1 : 0;
+        if (t < 0)
+            t += 4294967296LL;
+        res.m_limbs[i] = (uint32_t)t;
+    }
+}
+
+bool BigFixed::IsZero() const
+{
+    for (const uint32_t limb : m_limbs)
+    {
+        if (limb != 0)
+            return false;
+    }
+
+    return true;
+}
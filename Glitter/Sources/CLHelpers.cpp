@@ -0,0 +1,62 @@
+#include "CLHelpers.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <limits.h>
+#endif
+
+std::string ReadFile2(const char* f_name)
+{
+    std::string kernel_code;
+    std::ifstream kernel_file;
+    // ensure ifstream objects can throw exceptions:
+    kernel_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try
+    {
+        
+        kernel_file.open(f_name);
+        std::stringstream kernel_stream;
+        
+        kernel_stream << kernel_file.rdbuf();
+        
+        kernel_file.close();
+        
+        kernel_code = kernel_stream.str();
+    }
+    catch (std::ifstream::failure& e)
+    {
+        std::cout << "ERROR::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+    }
+
+    // return char sequence
+    return kernel_code.c_str();
+}
+
+std::string GetKernelPath(const char* file_name)
+{
+#ifdef _WIN32
+    char buffer[1024];
+    GetModuleFileName(NULL, buffer, sizeof(buffer));
+    std::string kernel_char(buffer);
+    kernel_char += "\\..\\";
+    kernel_char += file_name;
+    return kernel_char;
+#else
+    char buffer[PATH_MAX];
+    const ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer) - 1);
+    if (len <= 0)
+        return file_name;
+
+    buffer[len] = '\0';
+    std::string kernel_char(buffer);
+    kernel_char = kernel_char.substr(0, kernel_char.find_last_of('/') + 1);
+    kernel_char += file_name;
+    return kernel_char;
+#endif
+}
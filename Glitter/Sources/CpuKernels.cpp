@@ -0,0 +1,146 @@
+#include "CpuIterate.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CPU_X86
+#endif
+
+static void IterateScalar(const CpuView& view, int xBegin, int yBegin, int xEnd, int yEnd, float* samples, CpuStats& stats)
+{
+    IterateTile<SimdScalar>(view, xBegin, yBegin, xEnd, yEnd, samples, stats);
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+static void IterateSSE2(const CpuView& view, int xBegin, int yBegin, int xEnd, int yEnd, float* samples, CpuStats& stats)
+{
+    IterateTile<SimdSSE2>(view, xBegin, yBegin, xEnd, yEnd, samples, stats);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+static void IterateNEON(const CpuView& view, int xBegin, int yBegin, int xEnd, int yEnd, float* samples, CpuStats& stats)
+{
+    IterateTile<SimdNEON>(view, xBegin, yBegin, xEnd, yEnd, samples, stats);
+}
+#endif
+
+#ifdef CPU_X86
+// Whether the CPU and the OS (saved register state) support AVX2 and AVX-512F
+static void DetectX86(bool& avx2, bool& avx512)
+{
+    avx2 = false;
+    avx512 = false;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave)
+        return;
+
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+    avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+#else
+    // libgcc also checks the OS enabled the register state
+    __builtin_cpu_init();
+    avx2 = __builtin_cpu_supports("avx2") != 0;
+    avx512 = __builtin_cpu_supports("avx512f") != 0;
+#endif
+}
+#endif
+
+CpuIsa DetectCpuIsa()
+{
+    const CpuIsa candidates[] = { CpuIsa::AVX512, CpuIsa::AVX2, CpuIsa::NEON, CpuIsa::SSE2 };
+    for (CpuIsa isa : candidates)
+    {
+        if (GetCpuIterate(isa) != NULL)
+            return isa;
+    }
+
+    return CpuIsa::Scalar;
+}
+
+const char* CpuIsaName(CpuIsa isa)
+{
+    switch (isa)
+    {
+    case CpuIsa::Scalar:
+        return "scalar";
+    case CpuIsa::SSE2:
+        return "sse2";
+    case CpuIsa::AVX2:
+        return "avx2";
+    case CpuIsa::AVX512:
+        return "avx512";
+    case CpuIsa::NEON:
+        return "neon";
+    }
+
+    return "unknown";
+}
+
+bool CpuIsaFromName(const std::string& name, CpuIsa& isa)
+{
+    const CpuIsa all[] = { CpuIsa::Scalar, CpuIsa::SSE2, CpuIsa::AVX2, CpuIsa::AVX512, CpuIsa::NEON };
+    for (CpuIsa candidate : all)
+    {
+        if (name == CpuIsaName(candidate))
+        {
+            isa = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+CpuIterateFunc GetCpuIterate(CpuIsa isa)
+{
+#ifdef CPU_X86
+    bool avx2 = false;
+    bool avx512 = false;
+    DetectX86(avx2, avx512);
+#endif
+
+    switch (isa)
+    {
+    case CpuIsa::Scalar:
+        return IterateScalar;
+    case CpuIsa::SSE2:
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        return IterateSSE2;
+#else
+        return NULL;
+#endif
+    case CpuIsa::AVX2:
+#ifdef CPU_X86
+        return avx2 ? GetCpuIterateAVX2() : NULL;
+#else
+        return NULL;
+#endif
+    case CpuIsa::AVX512:
+#ifdef CPU_X86
+        return avx512 ? GetCpuIterateAVX512() : NULL;
+#else
+        return NULL;
+#endif
+    case CpuIsa::NEON:
+#if defined(__ARM_NEON) && defined(__aarch64__)
+        return IterateNEON;
+#else
+        return NULL;
+#endif
+    }
+
+    return NULL;
+}
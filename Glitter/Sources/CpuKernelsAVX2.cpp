@@ -0,0 +1,19 @@
+// Built with AVX2 enabled (see CMakeLists.txt) and only called after runtime detection
+#include "CpuIterate.hpp"
+
+#if defined(__AVX2__)
+static void IterateAVX2(const CpuView& view, int xBegin, int yBegin, int xEnd, int yEnd, float* samples, CpuStats& stats)
+{
+    IterateTile<SimdAVX2>(view, xBegin, yBegin, xEnd, yEnd, samples, stats);
+}
+
+CpuIterateFunc GetCpuIterateAVX2()
+{
+    return IterateAVX2;
+}
+#else
+CpuIterateFunc GetCpuIterateAVX2()
+{
+    return NULL;
+}
+#endif
@@ -0,0 +1,19 @@
+// Built with AVX-512F enabled (see CMakeLists.txt) and only called after runtime detection
+#include "CpuIterate.hpp"
+
+#if defined(__AVX512F__)
+static void IterateAVX512(const CpuView& view, int xBegin, int yBegin, int xEnd, int yEnd, float* samples, CpuStats& stats)
+{
+    IterateTile<SimdAVX512>(view, xBegin, yBegin, xEnd, yEnd, samples, stats);
+}
+
+CpuIterateFunc GetCpuIterateAVX512()
+{
+    return IterateAVX512;
+}
+#else
+CpuIterateFunc GetCpuIterateAVX512()
+{
+    return NULL;
+}
+#endif
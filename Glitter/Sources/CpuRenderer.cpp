@@ -0,0 +1,231 @@
+#include "CpuRenderer.hpp"
+#include "Headless.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // write_imagef into a CL_UNORM_INT8 image: saturate, scale and round to nearest even
+    unsigned char ToUnorm(float value)
+    {
+        const float clamped = std::min(std::max(value, 0.0f), 1.0f);
+        return (unsigned char)std::nearbyint(clamped * 255.0f);
+    }
+
+    // read_imagef from a CL_UNORM_INT8 image
+    float FromUnorm(unsigned char value)
+    {
+        return value / 255.0f;
+    }
+
+    // Mandel or PaletteColor (smooth) coloring of one sample
+    void ColorPixel(CpuKernel kernel, const Params& params, const std::vector<cl_float4>& lut, float period, const float* sample,
+        unsigned char* pixel)
+    {
+        const int iter = (int)sample[0];
+        float col[3];
+
+        if (kernel == CpuKernel::Mandel)
+        {
+            col[0] = (float)(iter / 256 * 5 + 127) / 255.0f;
+            col[1] = (float)(iter % 256) / 255.0f;
+            col[2] = 127.0f / 255.0f;
+        }
+        else if (iter >= params.maxIter || iter <= 0)
+        {
+            col[0] = col[1] = col[2] = 0.0f;
+        }
+        else
+        {
+            const float log_zn = std::log(sample[1]) / 2;
+            const float nu = std::log(log_zn / std::log(2.0f)) / std::log(2.0f);
+            const float flIter = iter + 1 - nu;
+
+            const cl_float4 color = Palette::Sample(lut, flIter * (params.paletteDensity / period) + params.paletteOffset / period, true);
+            for (int c = 0; c < 3; c++)
+                col[c] = color.s[c] * params.exposure;
+        }
+
+        for (int c = 0; c < 3; c++)
+            pixel[c] = ToUnorm(col[c]);
+        pixel[3] = 255;
+    }
+}
+
+CpuRenderer::CpuRenderer(int width, int height)
+    :
+    m_width(width),
+    m_height(height),
+    m_isa(CpuIsa::Scalar),
+    m_iterate(NULL),
+    m_tileSize(32),
+    m_tilesX(0),
+    m_tileCount(0),
+    m_period(1.0f),
+    m_verbose(true)
+{
+}
+
+bool CpuRenderer::Init(const std::string& isaName, int threadCount, int tileSize)
+{
+    if (isaName.empty())
+        m_isa = DetectCpuIsa();
+    else if (!CpuIsaFromName(isaName, m_isa))
+    {
+        std::cout << "Error unknown instruction set " << isaName << "\n";
+        return false;
+    }
+
+    m_iterate = GetCpuIterate(m_isa);
+    if (m_iterate == NULL)
+    {
+        std::cout << "Error instruction set " << isaName << " is not supported on this CPU\n";
+        return false;
+    }
+
+    m_scheduler.reset(new TileScheduler(threadCount));
+    m_tileSize = std::max(tileSize, 1);
+    m_tilesX = (m_width + m_tileSize - 1) / m_tileSize;
+    m_tileCount = m_tilesX * ((m_height + m_tileSize - 1) / m_tileSize);
+    m_tileCosts.clear();
+
+    std::cout << "Using CPU renderer: " << CpuIsaName(m_isa) << ", " << m_scheduler->GetThreadCount() << " threads, "
+        << m_tileSize << "x" << m_tileSize << " tiles\n";
+
+    m_samples.resize((size_t)m_width * m_height * 2);
+    if (m_lut.empty())
+        SetPalette(Palette());
+    m_pixels.resize((size_t)m_width * m_height * 4);
+    m_filtered.resize(m_pixels.size());
+
+    return true;
+}
+
+bool CpuRenderer::Render(const Params& params, CpuKernel kernel)
+{
+    if (m_iterate == NULL)
+        return false;
+
+    CpuView view;
+    view.width = m_width;
+    view.height = m_height;
+    view.dx = (float)params.dx;
+    view.dy = (float)params.dy;
+    view.scale = (float)params.scale;
+    view.maxIter = params.maxIter;
+    // Mandel always escapes at radius 2, MandelSmooth at the program's BAILOUT
+    view.bailout = kernel == CpuKernel::Mandel ? 4.0f : (float)(params.bailout * params.bailout);
+    view.periodCheck = params.GetPeriodCheck();
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Counters per worker, summed once the frame is done
+    std::vector<CpuStats> workerStats(m_scheduler->GetThreadCount());
+    m_scheduler->Run(m_tileCount, [&](int tile, int worker)
+    {
+        int x0, y0, x1, y1;
+        GetTile(tile, x0, y0, x1, y1);
+
+        CpuStats stats;
+        m_iterate(view, x0, y0, x1, y1, &m_samples[0], stats);
+        Color(kernel, params, x0, y0, x1, y1);
+
+        workerStats[worker].cardioidExits += stats.cardioidExits;
+        workerStats[worker].periodicExits += stats.periodicExits;
+    }, &m_tileCosts);
+    const long long steals = m_scheduler->GetSteals();
+
+    // Every tile reads its neighbors' pixels, so filtering is a second pass
+    if (params.filterOn)
+    {
+        m_scheduler->Run(m_tileCount, [this](int tile, int)
+        {
+            int x0, y0, x1, y1;
+            GetTile(tile, x0, y0, x1, y1);
+            Filter(x0, y0, x1, y1);
+        });
+        m_pixels.swap(m_filtered);
+    }
+
+    m_stats = CpuStats();
+    for (const CpuStats& stats : workerStats)
+    {
+        m_stats.cardioidExits += stats.cardioidExits;
+        m_stats.periodicExits += stats.periodicExits;
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!m_verbose)
+        return true;
+
+    std::cout << "CPU frame: " << ms << " ms, " << m_tileCount << " tiles, " << steals << " stolen\n";
+
+    if (params.interiorChecks)
+    {
+        std::cout << "Interior early-outs: " << m_stats.cardioidExits << " cardioid/bulb, "
+            << m_stats.periodicExits << " periodic\n";
+    }
+
+    return true;
+}
+
+void CpuRenderer::SetPalette(const Palette& palette)
+{
+    m_lut = palette.Bake();
+    m_period = palette.GetPeriod();
+}
+
+void CpuRenderer::Color(CpuKernel kernel, const Params& params, int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; y++)
+    {
+        for (int x = x0; x < x1; x++)
+        {
+            const size_t p = (size_t)y * m_width + x;
+            ColorPixel(kernel, params, m_lut, m_period, &m_samples[2 * p], &m_pixels[4 * p]);
+        }
+    }
+}
+
+void CpuRenderer::Filter(int x0, int y0, int x1, int y1)
+{
+    static const int k[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 };
+
+    for (int y = y0; y < y1; y++)
+    {
+        for (int x = x0; x < x1; x++)
+        {
+            float sum[3] = { 0.0f, 0.0f, 0.0f };
+            // Same tap order as GaussianFilter, clamped to the edge like its sampler
+            for (int j = 0; j < 9; j++)
+            {
+                const int sx = std::min(std::max(x + j % 3 - 1, 0), m_width - 1);
+                const int sy = std::min(std::max(y + j / 3 - 1, 0), m_height - 1);
+                const unsigned char* src = &m_pixels[4 * ((size_t)sy * m_width + sx)];
+                for (int c = 0; c < 3; c++)
+                    sum[c] += k[j] * FromUnorm(src[c]);
+            }
+
+            unsigned char* pixel = &m_filtered[4 * ((size_t)y * m_width + x)];
+            for (int c = 0; c < 3; c++)
+                pixel[c] = ToUnorm(sum[c] / 16);
+            pixel[3] = 255;
+        }
+    }
+}
+
+void CpuRenderer::GetTile(int tile, int& x0, int& y0, int& x1, int& y1) const
+{
+    x0 = tile % m_tilesX * m_tileSize;
+    y0 = tile / m_tilesX * m_tileSize;
+    x1 = std::min(x0 + m_tileSize, m_width);
+    y1 = std::min(y0 + m_tileSize, m_height);
+}
+
+bool CpuRenderer::WriteImage(const std::string& path) const
+{
+    return WritePng(path, m_width, m_height, m_pixels);
+}
@@ -0,0 +1,162 @@
+#include "DeepZoom.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+DeepZoom::DeepZoom()
+    :
+    m_useDouble(false),
+    m_orbitDirty(true),
+    m_orbitLimbs(0),
+    m_orbitMaxIter(0),
+    m_orbitBailout(0.0),
+    m_orbitLength(0)
+{
+}
+
+bool DeepZoom::Init(const cl::Context& context, const cl::Device& device, const cl::Program& program)
+{
+    m_context = context;
+    if (!SetProgram(program))
+        return false;
+
+    // Must match the pert_t typedef in mandel.cl
+    m_useDouble = device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_fp64") != std::string::npos;
+    std::cout << "Deep zoom deltas in " << (m_useDouble ? "double" : "float") << " precision\n";
+
+    return true;
+}
+
+bool DeepZoom::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_kernel = cl::Kernel(program, "MandelPerturb", &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating MandelPerturb kernel" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+void DeepZoom::SetCenter(const std::string& re, const std::string& im)
+{
+    m_centerRe = BigFixed::FromString(re);
+    m_centerIm = BigFixed::FromString(im);
+    m_orbitDirty = true;
+}
+
+void DeepZoom::SetCenter(double re, double im)
+{
+    const BigFixed centerRe = BigFixed::FromDouble(re, m_centerRe.GetLimbs());
+    const BigFixed centerIm = BigFixed::FromDouble(im, m_centerIm.GetLimbs());
+    if (centerRe == m_centerRe && centerIm == m_centerIm)
+        return;
+
+    m_centerRe = centerRe;
+    m_centerIm = centerIm;
+    m_orbitDirty = true;
+}
+
+void DeepZoom::Offset(double re, double im)
+{
+    m_centerRe = m_centerRe + BigFixed::FromDouble(re, m_centerRe.GetLimbs());
+    m_centerIm = m_centerIm + BigFixed::FromDouble(im, m_centerIm.GetLimbs());
+    m_orbitDirty = true;
+}
+
+bool DeepZoom::Render(const cl::CommandQueue& queue, const cl::Buffer& samples, int width, int height,
+    double scale, int maxIter, double bailout, const RenderPass& pass, cl::Event* event)
+{
+    // Grow the center precision with the zoom so offsets keep landing on pixels
+    const int limbs = BigFixed::LimbsForScale(scale);
+    if (limbs > m_centerRe.GetLimbs())
+    {
+        m_centerRe = m_centerRe.Resized(limbs);
+        m_centerIm = m_centerIm.Resized(limbs);
+    }
+
+    if (m_orbitDirty || limbs > m_orbitLimbs || maxIter != m_orbitMaxIter || bailout != m_orbitBailout)
+        ComputeReferenceOrbit(std::max(limbs, m_centerRe.GetLimbs()), maxIter, bailout);
+
+    // Upload the orbit in the kernel's delta type
+    cl_int err = CL_SUCCESS;
+    if (m_orbitDirty)
+    {
+        const size_t bytes = m_orbitLength * 2 * (m_useDouble ? sizeof(cl_double) : sizeof(cl_float));
+        if (m_useDouble)
+        {
+            m_orbitBuffer = cl::Buffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, &m_orbit[0], &err);
+        }
+        else
+        {
+            std::vector<float> orbitFloat(m_orbit.begin(), m_orbit.end());
+            m_orbitBuffer = cl::Buffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, &orbitFloat[0], &err);
+        }
+
+        if (err != CL_SUCCESS) {
+            std::cout << "Error uploading reference orbit" << " " << err << "\n";
+            return false;
+        }
+        m_orbitDirty = false;
+    }
+
+    cl_int2 size;
+    size.s[0] = width;
+    size.s[1] = height;
+    m_kernel.setArg(0, size);
+    m_kernel.setArg(1, m_orbitBuffer);
+    m_kernel.setArg(2, m_orbitLength);
+    if (m_useDouble)
+        m_kernel.setArg(3, (cl_double)scale);
+    else
+        m_kernel.setArg(3, (cl_float)std::min(scale, GetMaxScale()));
+    m_kernel.setArg(4, samples);
+    m_kernel.setArg(5, pass.step);
+    m_kernel.setArg(6, pass.prevStep);
+
+    err = queue.enqueueNDRangeKernel(m_kernel, pass.GetOffset(), pass.GetGlobal(width, height), cl::NullRange, NULL, event);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing MandelPerturb" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+void DeepZoom::ComputeReferenceOrbit(int limbs, int maxIter, double bailout)
+{
+    const BigFixed cr = m_centerRe.Resized(limbs);
+    const BigFixed ci = m_centerIm.Resized(limbs);
+    BigFixed zr(limbs);
+    BigFixed zi(limbs);
+
+    // Z_0 = 0; keep only non-escaped values, but always at least Z_0 and Z_1
+    m_orbit.clear();
+    m_orbit.reserve(2 * (maxIter + 1));
+    m_orbit.push_back(0.0);
+    m_orbit.push_back(0.0);
+
+    for (int i = 0; i < maxIter; i++)
+    {
+        const BigFixed zr2 = zr * zr;
+        const BigFixed zi2 = zi * zi;
+        const BigFixed zri = zr * zi;
+        zr = zr2 - zi2 + cr;
+        zi = zri + zri + ci;
+
+        const double re = zr.ToDouble();
+        const double im = zi.ToDouble();
+        if (re * re + im * im > bailout * bailout && i > 0)
+            break;
+
+        m_orbit.push_back(re);
+        m_orbit.push_back(im);
+    }
+
+    m_orbitLength = (int)(m_orbit.size() / 2);
+    m_orbitLimbs = limbs;
+    m_orbitMaxIter = maxIter;
+    m_orbitBailout = bailout;
+    m_orbitDirty = true;
+}
@@ -0,0 +1,138 @@
+#include "DeviceSelection.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+static std::string ToLower(std::string text)
+{
+    for (size_t i = 0; i < text.length(); i++)
+        text[i] = (char)tolower((unsigned char)text[i]);
+    return text;
+}
+
+static const char* TypeName(cl_device_type type)
+{
+    if (type & CL_DEVICE_TYPE_GPU)
+        return "GPU";
+    if (type & CL_DEVICE_TYPE_ACCELERATOR)
+        return "accelerator";
+    if (type & CL_DEVICE_TYPE_CPU)
+        return "CPU";
+    return "other";
+}
+
+bool DeviceInfo::Supports(DeviceMode mode) const
+{
+    if (!images)
+        return false;
+    return mode != DeviceMode::Interactive || glSharing;
+}
+
+double DeviceInfo::GetScore(DeviceMode mode) const
+{
+    if (!Supports(mode))
+        return 0.0;
+
+    // A GPU compute unit runs far more float lanes than a CPU core
+    double lanes = 4.0;
+    if (type & (CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR))
+        lanes = unifiedMemory ? 32.0 : 64.0;
+
+    double score = computeUnits * (double)std::max<cl_uint>(clock, 1) * lanes;
+    // Double views run natively instead of in double-single; GPUs pick double-single anyway
+    if (fp64 && !(type & CL_DEVICE_TYPE_GPU))
+        score *= 1.25;
+
+    return score;
+}
+
+std::vector<DeviceInfo> EnumerateDevices()
+{
+    std::vector<DeviceInfo> all_devices;
+    std::vector<cl::Platform> all_platforms;
+    cl::Platform::get(&all_platforms);
+
+    for (const cl::Platform& platform : all_platforms)
+    {
+        std::vector<cl::Device> devices;
+        platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+        for (const cl::Device& device : devices)
+        {
+            const std::string extensions = device.getInfo<CL_DEVICE_EXTENSIONS>();
+
+            DeviceInfo info;
+            info.platform = platform;
+            info.device = device;
+            info.index = (int)all_devices.size();
+            info.name = device.getInfo<CL_DEVICE_NAME>();
+            info.platformName = platform.getInfo<CL_PLATFORM_NAME>();
+            info.type = device.getInfo<CL_DEVICE_TYPE>();
+            info.computeUnits = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+            info.clock = device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>();
+            info.fp64 = extensions.find("cl_khr_fp64") != std::string::npos;
+            info.images = device.getInfo<CL_DEVICE_IMAGE_SUPPORT>() != CL_FALSE;
+            info.glSharing = extensions.find("cl_khr_gl_sharing") != std::string::npos ||
+                extensions.find("cl_APPLE_gl_sharing") != std::string::npos;
+            info.unifiedMemory = device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>() != CL_FALSE;
+            all_devices.push_back(info);
+        }
+    }
+
+    return all_devices;
+}
+
+void PrintDevices(const std::vector<DeviceInfo>& devices, DeviceMode mode)
+{
+    std::cout << "OpenCL devices:\n";
+    for (const DeviceInfo& info : devices)
+    {
+        char line[512];
+        snprintf(line, sizeof(line), "  [%d] %s (%s, %s): %u CUs @ %u MHz, fp64 %s, images %s, GL sharing %s, score %.0f\n",
+            info.index, info.name.c_str(), info.platformName.c_str(), TypeName(info.type), info.computeUnits, info.clock,
+            info.fp64 ? "yes" : "no", info.images ? "yes" : "no", info.glSharing ? "yes" : "no", info.GetScore(mode));
+        std::cout << line;
+    }
+}
+
+std::vector<DeviceInfo> RankDevices(const std::vector<DeviceInfo>& devices, DeviceMode mode, const std::string& request)
+{
+    std::vector<DeviceInfo> ranked;
+
+    if (!request.empty())
+    {
+        // All digits: an index, anything else: part of a name
+        const bool isIndex = request.find_first_not_of("0123456789") == std::string::npos;
+        const std::string needle = ToLower(request);
+        for (const DeviceInfo& info : devices)
+        {
+            const bool match = isIndex ? info.index == atoi(request.c_str()) :
+                ToLower(info.name).find(needle) != std::string::npos || ToLower(info.platformName).find(needle) != std::string::npos;
+            if (!match)
+                continue;
+
+            if (!info.Supports(mode))
+            {
+                std::cout << "Device " << info.name << " lacks " << (info.images ? "GL sharing" : "image support") << "\n";
+                continue;
+            }
+
+            ranked.push_back(info);
+            return ranked;
+        }
+
+        std::cout << "No usable device matches " << request << "\n";
+        return ranked;
+    }
+
+    for (const DeviceInfo& info : devices)
+    {
+        if (info.Supports(mode))
+            ranked.push_back(info);
+    }
+
+    std::stable_sort(ranked.begin(), ranked.end(), [mode](const DeviceInfo& a, const DeviceInfo& b) { return a.GetScore(mode) > b.GetScore(mode); });
+    return ranked;
+}
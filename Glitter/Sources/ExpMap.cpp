@@ -0,0 +1,212 @@
+#include "ExpMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// View at scale 1 around the zoom target, must match xMinMax and yMinMax in mandel.cl
+static const double xMin = -2.0;
+static const double xMax = 0.47;
+static const double yMin = -1.12;
+static const double yMax = 1.12;
+
+static const double twoPi = 6.283185307179586;
+
+ExpMap::ExpMap()
+    :
+    m_width(0),
+    m_height(0),
+    m_hasFp64(false),
+    m_maxAlloc(0),
+    m_dx(0.0),
+    m_dy(0.0),
+    m_startScale(1.0),
+    m_radius0(1.0),
+    m_angleStep(1.0),
+    m_stripWidth(0),
+    m_ringRows(0),
+    m_frameRows(0.0),
+    m_firstRow(0),
+    m_nextRow(0),
+    m_iteratedSamples(0)
+{
+}
+
+bool ExpMap::Init(const cl::Device& device, const cl::Context& context, const cl::Program& program, int width, int height,
+    const cl::Buffer& earlyExits)
+{
+    m_context = context;
+    m_width = width;
+    m_height = height;
+    m_earlyExits = earlyExits;
+    m_hasFp64 = device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_fp64") != std::string::npos;
+    m_maxAlloc = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+
+    return SetProgram(program);
+}
+
+bool ExpMap::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_floatKernel = cl::Kernel(program, "ExpMapStrip", &err);
+    if (err == CL_SUCCESS)
+        m_dsKernel = cl::Kernel(program, "ExpMapStripDS", &err);
+    if (err == CL_SUCCESS && m_hasFp64)
+        m_doubleKernel = cl::Kernel(program, "ExpMapStripF64", &err);
+    if (err == CL_SUCCESS)
+        m_frameKernel = cl::Kernel(program, "ExpMapFrame", &err);
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating exponential map kernels" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool ExpMap::Begin(const Params& params)
+{
+    m_dx = params.dx;
+    m_dy = params.dy;
+    m_startScale = params.scale;
+
+    // Farthest frame corner and pixel spacing, both at scale 1
+    const double cornerRadius = std::sqrt(std::max(xMin * xMin, xMax * xMax) + std::max(yMin * yMin, yMax * yMax));
+    const double spacing = std::min((xMax - xMin) / m_width, (yMax - yMin) / m_height);
+
+    // Strip samples as far apart as pixels at the frame corners, closer everywhere inside;
+    // the ring grows with the square of the strip width, which shrinks to fit one allocation
+    double stripWidth = std::ceil(twoPi * cornerRadius / spacing);
+    for (;;)
+    {
+        m_stripWidth = (int)stripWidth;
+        m_angleStep = twoPi / m_stripWidth;
+        m_frameRows = std::log(cornerRadius / (0.5 * spacing)) / m_angleStep;
+        m_ringRows = (int)std::ceil(m_frameRows) + 4;
+
+        const double bytes = sizeof(cl_float) * (double)m_stripWidth * m_ringRows;
+        if (bytes <= m_maxAlloc)
+            break;
+
+        stripWidth = std::floor(stripWidth * std::sqrt(m_maxAlloc / bytes) * 0.95);
+        std::cout << "Exponential map strip exceeds the largest device allocation, narrowing it to " << stripWidth << " samples\n";
+    }
+
+    m_radius0 = cornerRadius / m_startScale;
+    m_firstRow = 0;
+    m_nextRow = 0;
+    m_iteratedSamples = 0;
+
+    cl_int err = CL_SUCCESS;
+    m_strip = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(cl_float) * m_stripWidth * m_ringRows, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating exponential map strip" << " " << err << "\n";
+        return false;
+    }
+
+    std::cout << "Exponential map: " << m_stripWidth << " samples per row, zoom by e every " << (int)(1.0 / m_angleStep)
+        << " rows, " << m_ringRows << " rows in the ring\n";
+    return true;
+}
+
+bool ExpMap::Render(const cl::CommandQueue& queue, const MandelVariants& variants, const cl::Buffer& samples, const Params& params)
+{
+    // Rows from the frame corners (first) to half a pixel from the target (last)
+    const double zoom = std::log(params.scale / m_startScale);
+    const double firstRow = zoom / m_angleStep;
+    const int rowBegin = (int)std::floor(firstRow);
+    const int rowEnd = (int)std::ceil(firstRow + m_frameRows) + 2;
+    if (rowBegin < m_firstRow) {
+        std::cout << "Error exponential map frames must zoom in\n";
+        return false;
+    }
+
+    // Rows a large step skipped over are never needed again
+    if (rowBegin > m_nextRow)
+    {
+        m_firstRow = rowBegin;
+        m_nextRow = rowBegin;
+    }
+
+    for (int row = m_nextRow; row < rowEnd; row += bandRows)
+    {
+        if (!RenderRows(queue, variants, params, row, std::min(row + bandRows, rowEnd)))
+            return false;
+    }
+    m_nextRow = std::max(m_nextRow, rowEnd);
+    m_firstRow = std::max(m_firstRow, m_nextRow - m_ringRows);
+
+    cl_int2 size;
+    size.s[0] = m_width;
+    size.s[1] = m_height;
+    m_frameKernel.setArg(0, size);
+    m_frameKernel.setArg(1, m_strip);
+    m_frameKernel.setArg(2, (cl_int)m_stripWidth);
+    m_frameKernel.setArg(3, (cl_int)m_ringRows);
+    m_frameKernel.setArg(4, (cl_int)rowBegin);
+    m_frameKernel.setArg(5, (cl_int)(rowEnd - 1));
+    m_frameKernel.setArg(6, (cl_float)(std::log(m_radius0 * m_startScale) + zoom));
+    m_frameKernel.setArg(7, samples);
+    const cl_int err = queue.enqueueNDRangeKernel(m_frameKernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing ExpMapFrame" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool ExpMap::RenderRows(const cl::CommandQueue& queue, const MandelVariants& variants, const Params& params, int rowBegin, int rowEnd)
+{
+    // The deepest row of the band has the closest samples
+    const double spacing = m_radius0 * std::exp(-m_angleStep * (rowEnd - 1)) * m_angleStep;
+    const Precision precision = params.autoPrecision ? variants.SelectForSpacing(spacing, m_dx, m_dy) : Precision::Float;
+
+    cl::Kernel* kernel = &m_floatKernel;
+    if (precision == Precision::Perturbation)
+    {
+        std::cout << "Error exponential map zoom is deeper than double precision resolves\n";
+        return false;
+    }
+    else if (precision == Precision::Double && m_hasFp64)
+    {
+        kernel = &m_doubleKernel;
+        kernel->setArg(3, (cl_double)m_dx);
+        kernel->setArg(4, (cl_double)m_dy);
+    }
+    else if (precision == Precision::DoubleSingle || precision == Precision::Double)
+    {
+        // Split the target into hi + lo floats
+        cl_float2 dx;
+        cl_float2 dy;
+        dx.s[0] = (cl_float)m_dx;
+        dx.s[1] = (cl_float)(m_dx - dx.s[0]);
+        dy.s[0] = (cl_float)m_dy;
+        dy.s[1] = (cl_float)(m_dy - dy.s[0]);
+
+        kernel = &m_dsKernel;
+        kernel->setArg(3, dx);
+        kernel->setArg(4, dy);
+    }
+    else
+    {
+        kernel->setArg(3, (cl_float)m_dx);
+        kernel->setArg(4, (cl_float)m_dy);
+    }
+
+    kernel->setArg(0, (cl_int)m_stripWidth);
+    kernel->setArg(1, (cl_int)rowBegin);
+    kernel->setArg(2, (cl_int)m_ringRows);
+    kernel->setArg(5, (cl_float)m_radius0);
+    kernel->setArg(6, m_strip);
+    kernel->setArg(7, params.GetPeriodCheck());
+    kernel->setArg(8, m_earlyExits);
+    const cl_int err = queue.enqueueNDRangeKernel(*kernel, cl::NullRange, cl::NDRange(m_stripWidth, rowEnd - rowBegin));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing ExpMapStrip" << " " << err << "\n";
+        return false;
+    }
+
+    m_iteratedSamples += (long long)m_stripWidth * (rowEnd - rowBegin);
+    return true;
+}
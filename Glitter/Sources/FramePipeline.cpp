@@ -0,0 +1,229 @@
+#include "FramePipeline.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+FramePipeline::FramePipeline()
+    :
+    m_width(0),
+    m_height(0),
+    m_current(-1),
+    m_queued(-1),
+    m_ready(-1),
+    m_shown(-1),
+    m_implicitSync(false)
+{
+}
+
+bool FramePipeline::Init(const cl::Context& context, const cl::Device& device, int width, int height)
+{
+    m_context = context;
+    m_implicitSync = device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_gl_event") != std::string::npos;
+    std::cout << "CL/GL synchronization: " << (m_implicitSync ? "implicit (cl_khr_gl_event)" : "fences and events") << "\n";
+
+    return Resize(width, height);
+}
+
+bool FramePipeline::Resize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+
+    const int classWidth = (width + sizeClass - 1) / sizeClass * sizeClass;
+    const int classHeight = (height + sizeClass - 1) / sizeClass * sizeClass;
+    if (!m_sets.empty() && m_sets[0].width == classWidth && m_sets[0].height == classHeight)
+        return true;
+
+    // Frames in flight live in the previous set
+    m_current = -1;
+    m_queued = -1;
+    m_ready = -1;
+    m_shown = -1;
+
+    size_t pooled = 0;
+    while (pooled < m_sets.size() && (m_sets[pooled].width != classWidth || m_sets[pooled].height != classHeight))
+        pooled++;
+
+    if (pooled < m_sets.size())
+    {
+        std::rotate(m_sets.begin(), m_sets.begin() + pooled, m_sets.begin() + pooled + 1);
+        return true;
+    }
+
+    TargetSet set;
+    if (!CreateSet(set, classWidth, classHeight))
+    {
+        DeleteSet(set);
+        return false;
+    }
+
+    m_sets.insert(m_sets.begin(), set);
+    if ((int)m_sets.size() > poolSize)
+    {
+        DeleteSet(m_sets.back());
+        m_sets.pop_back();
+    }
+
+    std::cout << "Render targets: " << classWidth << "x" << classHeight << "\n";
+    return true;
+}
+
+bool FramePipeline::CreateSet(TargetSet& set, int width, int height)
+{
+    cl_int err = CL_SUCCESS;
+    set.width = width;
+    set.height = height;
+
+    std::vector<GLubyte> emptyData((size_t)width * height * 4, 0);
+    for (int i = 0; i < targetCount; i++)
+    {
+        Target& target = set.targets[i];
+        glGenTextures(1, &target.texture);
+        glBindTexture(GL_TEXTURE_2D, target.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &emptyData[0]);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glGenFramebuffers(1, &target.framebuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    // CL may only touch the textures once GL is done creating them
+    glFinish();
+
+    for (int i = 0; i < targetCount && err == CL_SUCCESS; i++)
+        set.targets[i].image = clCreateFromGLTexture(m_context(), CL_MEM_READ_WRITE, GL_TEXTURE_2D, 0, set.targets[i].texture, &err);
+    if (err == CL_SUCCESS)
+        set.scratch = cl::Image2D(m_context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_UNORM_INT8), width, height, 0, NULL, &err);
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating shared render targets" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+void FramePipeline::DeleteSet(TargetSet& set)
+{
+    for (int i = 0; i < targetCount; i++)
+    {
+        Target& target = set.targets[i];
+        if (target.fence != 0)
+            glDeleteSync(target.fence);
+        target.image = cl::Image2D();
+        glDeleteFramebuffers(1, &target.framebuffer);
+        glDeleteTextures(1, &target.texture);
+        target = Target();
+    }
+    set.scratch = cl::Image2D();
+}
+
+const cl::Image2D& FramePipeline::BeginFrame(const cl::CommandQueue& queue)
+{
+    // Prefer a target that is neither waiting to be shown nor on screen; with two targets
+    // the one on screen is reused and the waiting one is shown instead
+    m_current = m_shown >= 0 ? m_shown : 0;
+    for (int i = 0; i < targetCount; i++)
+    {
+        if (i != m_ready && i != m_shown)
+        {
+            m_current = i;
+            break;
+        }
+    }
+
+    Target& target = m_sets[0].targets[m_current];
+    if (target.fence != 0)
+    {
+        // Set after the target's last blit, one frame ago
+        glClientWaitSync(target.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(target.fence);
+        target.fence = 0;
+    }
+    target.width = m_width;
+    target.height = m_height;
+
+    const cl_int err = clEnqueueAcquireGLObjects(queue(), 1, &target.image(), 0, NULL, NULL);
+    if (err != CL_SUCCESS)
+        std::cout << "Error acquiring GL objects" << " " << err << "\n";
+
+    return target.image;
+}
+
+bool FramePipeline::EndFrame(const cl::CommandQueue& queue)
+{
+    Target& target = m_sets[0].targets[m_current];
+    cl_event released = NULL;
+    cl_int err = clEnqueueReleaseGLObjects(queue(), 1, &target.image(), 0, NULL, &released);
+    if (err == CL_SUCCESS)
+    {
+        target.released = cl::Event(released);
+        err = queue.flush();
+    }
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error releasing GL objects" << " " << err << "\n";
+        return false;
+    }
+
+    m_queued = m_current;
+    m_current = -1;
+    return true;
+}
+
+void FramePipeline::Present(int windowWidth, int windowHeight)
+{
+    // After a size class change nothing is on screen, show this iteration's frame at once
+    // instead of a blank one
+    if (m_shown < 0 && m_ready < 0)
+    {
+        m_ready = m_queued;
+        m_queued = -1;
+    }
+
+    if (m_ready >= 0)
+    {
+        Target& target = m_sets[0].targets[m_ready];
+        if (!m_implicitSync)
+            target.released.wait();
+        m_shown = m_ready;
+
+        // We have to generate the mipmaps again!!!
+        glBindTexture(GL_TEXTURE_2D, target.texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    // This iteration's frame becomes presentable in the next one
+    m_ready = m_queued;
+    m_queued = -1;
+
+    if (m_shown < 0)
+        return;
+
+    Target& target = m_sets[0].targets[m_shown];
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, windowWidth, windowHeight,
+        GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    if (!m_implicitSync)
+    {
+        if (target.fence != 0)
+            glDeleteSync(target.fence);
+        target.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void FramePipeline::Cleanup()
+{
+    for (size_t i = 0; i < m_sets.size(); i++)
+        DeleteSet(m_sets[i]);
+    m_sets.clear();
+}
@@ -4,7 +4,9 @@
 GUI::GUI(GLFWwindow* pWindow, Timer& timer)
     :
     p_window(pWindow),
-    m_timer(timer)
+    m_timer(timer),
+    m_maxIterEdit(1000),
+    m_bailoutEdit(256.0)
 {
     cursor_enabled = true;
     clicked = false;
@@ -12,6 +14,42 @@ GUI::GUI(GLFWwindow* pWindow, Timer& timer)
     gui_enabled = true;
     animationSpeed = 1.0f;
     animationTime = 0.0f;
+    scale = 1.0;
+    maxIter = 1000;
+    bailout = 256.0;
+    programCount = 0;
+    programBinaryHits = 0;
+    precision = "float";
+    deepZoom = false;
+    referenceLength = 0;
+    progressive = false;
+    progressivePass = 0;
+    reprojected = false;
+    mariani = false;
+    marianiFilled = 0.0f;
+    interiorChecks = true;
+    histogram = false;
+    distanceEstimate = false;
+    palette = "classic";
+    paletteOffset = 0.0f;
+    paletteDensity = 1.0f;
+    exposure = 1.0f;
+    paletteCycle = false;
+    boundaryWidth = 1.0f;
+    antialias = false;
+    antialiasThreshold = 0.1f;
+    antialiasRefined = 0.0f;
+    dynamicResolution = false;
+    renderStep = 1;
+    kernelTime = 0.0f;
+    frameBudget = 16.0f;
+    accumulate = false;
+    accumulatedFrames = 1;
+    accumulateFrames = 64;
+    rendered = false;
+    recolored = false;
+    cardioidExits = 0;
+    periodicExits = 0;
 }
 
 void GUI::Init()
@@ -47,6 +85,63 @@ void GUI::Render()
     ImGui::Text("Animation time: %.2f", animationTime);
     ImGui::Text("Animation speed: %.1f", animationSpeed);
     ImGui::Separator();
+    ImGui::Text("Scale: %g", scale);
+    ImGui::Text("Precision: %s", precision);
+    ImGui::Text("Frame rendered: %s", rendered ? "yes" : (recolored ? "recolored only" : "no (unchanged)"));
+    // Every new combination builds a program, so typed values only apply once the field is
+    // left or Enter is pressed; meanwhile the fields follow changes made with the keys
+    ImGui::InputInt("Max iterations", &m_maxIterEdit, 0, 0);
+    if (ImGui::IsItemDeactivatedAfterEdit())
+        maxIter = m_maxIterEdit;
+    else if (!ImGui::IsItemActive())
+        m_maxIterEdit = maxIter;
+    ImGui::InputDouble("Bailout radius", &m_bailoutEdit, 0.0, 0.0, "%.1f");
+    if (ImGui::IsItemDeactivatedAfterEdit())
+        bailout = m_bailoutEdit;
+    else if (!ImGui::IsItemActive())
+        m_bailoutEdit = bailout;
+    ImGui::Text("Programs: %d (%d from binary cache)", programCount, programBinaryHits);
+    ImGui::Text("Deep zoom: %s", deepZoom ? "on" : "off");
+    if (deepZoom)
+        ImGui::Text("Reference orbit length: %d", referenceLength);
+    if (progressive)
+        ImGui::Text("Progressive pass: %d/3", progressivePass);
+    ImGui::Text("Reprojected frame: %s", reprojected ? "yes" : "no");
+    ImGui::Text("Dynamic resolution: %s", dynamicResolution ? "on" : "off");
+    if (dynamicResolution)
+    {
+        ImGui::Text("Sample step: %d (kernel %.2f ms)", renderStep, kernelTime);
+        ImGui::InputFloat("Frame budget (ms)", &frameBudget, 1.0f, 4.0f, "%.1f");
+    }
+    if (mariani)
+        ImGui::Text("Mariani-Silver filled: %.1f%%", marianiFilled * 100.0f);
+    if (interiorChecks)
+        ImGui::Text("Interior early-outs: %d cardioid/bulb, %d periodic", cardioidExits, periodicExits);
+    else
+        ImGui::Text("Interior early-outs: off");
+    ImGui::Text("Coloring: %s, palette %s", histogram ? "histogram" : "smooth", palette);
+    ImGui::InputFloat("Palette offset", &paletteOffset, 0.5f, 4.0f, "%.2f");
+    ImGui::InputFloat("Palette density", &paletteDensity, 0.1f, 1.0f, "%.2f");
+    ImGui::InputFloat("Exposure", &exposure, 0.1f, 0.5f, "%.2f");
+    ImGui::Checkbox("Palette cycling", &paletteCycle);
+    ImGui::Text("Distance estimation: %s", distanceEstimate ? "on (float views)" : "off");
+    if (distanceEstimate)
+        ImGui::InputFloat("Boundary width", &boundaryWidth, 0.25f, 1.0f, "%.2f");
+    ImGui::Text("Anti-aliasing: %s", antialias ? "on (float views)" : "off");
+    if (antialias)
+    {
+        ImGui::Text("Refined pixels: %.1f%%", antialiasRefined * 100.0f);
+        ImGui::InputFloat("Refine threshold", &antialiasThreshold, 0.01f, 0.05f, "%.3f");
+    }
+    ImGui::Text("Temporal accumulation: %s", accumulate ? "on (float views)" : "off");
+    if (accumulate)
+    {
+        ImGui::Text("Accumulated samples: %d", accumulatedFrames);
+        ImGui::InputInt("Sample target", &accumulateFrames, 16, 256);
+    }
+    for (const std::string& device : splitDevices)
+        ImGui::Text("%s", device.c_str());
+    ImGui::Separator();
     ImGui::Text("Mouse cursor stuff:");
     ImGui::Text("Cursor_x: %f", mouse_xpos);
     ImGui::Text("Cursor_y: %f", mouse_ypos);
@@ -0,0 +1,371 @@
+#include "Headless.hpp"
+#include "CLHelpers.hpp"
+#include "CpuRenderer.hpp"
+#include "MultiDevice.hpp"
+#include "Sequence.hpp"
+#include "DeviceSelection.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// The implementation leaves struct fields to zero initialization, which -Wextra flags
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+HeadlessRenderer::HeadlessRenderer(int width, int height)
+    :
+    m_width(width),
+    m_height(height),
+    m_verbose(true)
+{
+}
+
+bool HeadlessRenderer::Init(const Params& params, const std::string& deviceRequest)
+{
+    const std::vector<DeviceInfo> all_devices = EnumerateDevices();
+    if (all_devices.size() == 0) {
+        std::cout << " No devices found. Check OpenCL installation!\n";
+        return false;
+    }
+    PrintDevices(all_devices, DeviceMode::Headless);
+
+    // Best scoring device with image support (a CPU ICD like PoCL also works)
+    const std::vector<DeviceInfo> ranked = RankDevices(all_devices, DeviceMode::Headless, deviceRequest);
+    if (ranked.size() == 0)
+        return false;
+
+    m_device = ranked[0].device;
+    std::cout << "Using device: " << ranked[0].name << " (" << ranked[0].platformName << ")\n";
+
+    cl_int err = CL_SUCCESS;
+    m_context = cl::Context(m_device, NULL, NULL, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating context" << " " << err << "\n";
+        return false;
+    }
+
+    m_queue = cl::CommandQueue(m_context, m_device);
+
+    // Read kernel source and build
+    m_kernelSource = ReadFile2(GetKernelPath().c_str());
+    m_programCache.Init(m_context, m_device, m_kernelSource);
+    const cl::Program* program = m_programCache.Get(params.maxIter, params.bailout);
+    if (program == NULL)
+        return false;
+
+    m_filterKernel = cl::Kernel(*program, "GaussianFilter");
+    if (!m_stats.Init(m_context))
+        return false;
+    if (!m_variants.Init(m_device, *program, m_stats.GetBuffer()) || !m_deepZoom.Init(m_context, m_device, *program) ||
+        !m_expMap.Init(m_device, m_context, *program, m_width, m_height, m_stats.GetBuffer()))
+        return false;
+
+    m_image = cl::Image2D(m_context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_UNORM_INT8), m_width, m_height, 0, NULL, &err);
+    if (err == CL_SUCCESS)
+        m_filterImage = cl::Image2D(m_context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_UNORM_INT8), m_width, m_height, 0, NULL, &err);
+    if (err == CL_SUCCESS)
+        m_samples = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(cl_float2) * m_width * m_height, NULL, &err);
+    if (err == CL_SUCCESS)
+        m_distance = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(cl_float) * m_width * m_height, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating images and buffers" << " " << err << "\n";
+        return false;
+    }
+
+    if (!m_mariani.Init(m_context, *program, m_width, m_height, m_stats.GetBuffer()) ||
+        !m_histogram.Init(m_context, m_device, *program, m_width, m_height) ||
+        !m_coloring.Init(m_context, *program, m_width, m_height) ||
+        !m_adaptive.Init(m_context, *program, m_width, m_height, m_stats.GetBuffer()) ||
+        !m_temporal.Init(m_context, *program, m_width, m_height, m_stats.GetBuffer()))
+        return false;
+
+    m_pixels.resize((size_t)m_width * m_height * 4);
+
+    return true;
+}
+
+bool HeadlessRenderer::SetPalette(const Palette& palette)
+{
+    return m_coloring.SetPalette(palette);
+}
+
+bool HeadlessRenderer::UseProgram(const Params& params)
+{
+    const cl::Program* program = m_programCache.Get(params.maxIter, params.bailout);
+    return program != NULL && m_variants.SetProgram(*program) && m_mariani.SetProgram(*program) && m_deepZoom.SetProgram(*program) &&
+        m_expMap.SetProgram(*program) && m_histogram.SetProgram(*program) && m_coloring.SetProgram(*program) &&
+        m_adaptive.SetProgram(*program) && m_temporal.SetProgram(*program);
+}
+
+bool HeadlessRenderer::Render(const Params& params)
+{
+    if (!UseProgram(params))
+        return false;
+
+    const Precision precision = m_variants.Select(params, m_width);
+    if (m_verbose)
+        std::cout << "Rendering in " << PrecisionName(precision) << " precision\n";
+
+    if (!m_stats.Reset(m_queue))
+        return false;
+
+    if (precision == Precision::Perturbation)
+    {
+        if (!params.deepZoom)
+            m_deepZoom.SetCenter(params.dx, params.dy);
+        if (!m_deepZoom.Render(m_queue, m_samples, m_width, m_height, params.scale, params.maxIter, params.bailout))
+            return false;
+    }
+    else if (params.distanceEstimate && precision == Precision::Float)
+    {
+        if (!m_variants.RenderDistance(m_queue, m_samples, m_distance, m_width, m_height, params))
+            return false;
+    }
+    else if (params.mariani && precision == Precision::Float)
+    {
+        if (!m_mariani.Render(m_queue, m_samples, params))
+            return false;
+    }
+    else if (!m_variants.Render(m_queue, m_samples, m_width, m_height, params, precision))
+        return false;
+
+    // Only the float variant estimates distances, other views mark them unknown
+    if (params.distanceEstimate && precision != Precision::Float &&
+        m_queue.enqueueFillBuffer(m_distance, -1.0f, 0, sizeof(cl_float) * m_width * m_height) != CL_SUCCESS)
+        return false;
+
+    if (!Resolve(params, precision == Precision::Float))
+        return false;
+
+    if (m_verbose && params.antialias && precision == Precision::Float && !params.histogram)
+    {
+        m_adaptive.Update();
+        std::cout << "Anti-aliasing refined " << m_adaptive.GetRefinedFraction() * 100.0f << "% of the pixels\n";
+    }
+
+    if (m_verbose && params.interiorChecks && precision != Precision::Perturbation && m_stats.Read(m_queue))
+    {
+        std::cout << "Interior early-outs: " << m_stats.GetCardioidExits() << " cardioid/bulb, "
+            << m_stats.GetPeriodicExits() << " periodic\n";
+    }
+
+    return true;
+}
+
+bool HeadlessRenderer::BeginExpMap(const Params& params)
+{
+    return UseProgram(params) && m_expMap.Begin(params);
+}
+
+bool HeadlessRenderer::RenderExpMap(const Params& params)
+{
+    if (!UseProgram(params) || !m_stats.Reset(m_queue) || !m_expMap.Render(m_queue, m_variants, m_samples, params))
+        return false;
+
+    // Resampled frames have no distance estimates
+    if (params.distanceEstimate && m_queue.enqueueFillBuffer(m_distance, -1.0f, 0, sizeof(cl_float) * m_width * m_height) != CL_SUCCESS)
+        return false;
+
+    // Resampled frames are smooth already and their strip is not per pixel
+    return Resolve(params, false);
+}
+
+bool HeadlessRenderer::Resolve(const Params& params, bool refine)
+{
+    // Iteration only wrote samples, one of the coloring passes turns them into pixels
+    if (params.histogram)
+    {
+        if (!m_histogram.Render(m_queue, m_image, m_samples, m_coloring, params))
+            return false;
+    }
+    else
+    {
+        // Accumulation starts from the frame as colored, refined pixels included
+        const bool accumulate = params.accumulate && refine;
+        if (!m_coloring.Render(m_queue, m_image, m_samples, 1, params, 0, -1, &m_distance) ||
+            (accumulate && !m_temporal.Seed(m_queue, m_samples, m_coloring, params)) ||
+            (params.antialias && refine && !m_adaptive.Render(m_queue, m_image, m_samples, &m_distance, m_coloring, params, 0,
+                accumulate ? &m_temporal.GetBuffer() : NULL)))
+            return false;
+
+        // A still frame has no reason to stop early, all accumulation frames run back to back
+        while (accumulate && m_temporal.GetFrames() < params.accumulateFrames)
+        {
+            if (!m_temporal.Render(m_queue, m_image, &m_distance, m_coloring, params))
+                return false;
+        }
+    }
+
+    cl_int err = CL_SUCCESS;
+    cl::Image2D* result = &m_image;
+    if (params.filterOn)
+    {
+        m_filterKernel.setArg(0, m_image);
+        m_filterKernel.setArg(1, m_filterImage);
+        cl_int2 size;
+        size.s[0] = m_width;
+        size.s[1] = m_height;
+        m_filterKernel.setArg(2, size);
+        err = m_queue.enqueueNDRangeKernel(m_filterKernel, cl::NullRange, cl::NDRange(m_width, m_height));
+        result = &m_filterImage;
+    }
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing kernels" << " " << err << "\n";
+        return false;
+    }
+
+    cl::size_t<3> origin;
+    cl::size_t<3> region;
+    region[0] = m_width;
+    region[1] = m_height;
+    region[2] = 1;
+    err = m_queue.enqueueReadImage(*result, CL_TRUE, origin, region, 0, 0, &m_pixels[0]);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error reading image" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+// Float render on both backends, pixels differing by more than one level count as mismatches
+static bool CompareBackends(const Options& options, const Palette& palette)
+{
+    // Fraction of mismatching pixels tolerated, the device may contract into fma and use
+    // its own log, which moves a few pixels to a neighboring iteration count
+    const double maxMismatchRatio = 0.001;
+
+    Params params = options.params;
+    params.autoPrecision = false;
+    params.deepZoom = false;
+    params.mariani = false;
+    params.histogram = false;
+    params.antialias = false;
+    params.accumulate = false;
+
+    HeadlessRenderer gpu(options.width, options.height);
+    CpuRenderer cpu(options.width, options.height);
+    if (!gpu.Init(params, options.device) || !gpu.SetPalette(palette) || !cpu.Init(options.isa, options.threads, options.tileSize))
+        return false;
+    cpu.SetPalette(palette);
+    if (!gpu.Render(params) || !cpu.Render(params))
+        return false;
+
+    const std::vector<unsigned char>& a = gpu.GetPixels();
+    const std::vector<unsigned char>& b = cpu.GetPixels();
+    long long mismatches = 0;
+    int maxDiff = 0;
+    for (size_t p = 0; p < a.size(); p += 4)
+    {
+        int diff = 0;
+        for (int c = 0; c < 4; c++)
+            diff = std::max(diff, abs(a[p + c] - b[p + c]));
+        if (diff > 1)
+            mismatches++;
+        maxDiff = std::max(maxDiff, diff);
+    }
+
+    const double ratio = (double)mismatches / ((double)options.width * options.height);
+    std::cout << "CPU check: " << mismatches << " mismatching pixels (" << ratio * 100.0 << "%), max channel difference "
+        << maxDiff << "\n";
+
+    return ratio <= maxMismatchRatio;
+}
+
+// Float, double-single or double render split over every device, views that need
+// perturbation are rendered by a single device
+static bool RenderSplit(const Options& options, const Palette& palette)
+{
+    MultiDevice renderer(options.width, options.height);
+    if (!renderer.Init(options.params) || !renderer.SetPalette(palette))
+        return false;
+
+    const Precision precision = renderer.Select(options.params);
+    std::cout << "Rendering in " << PrecisionName(precision) << " precision\n";
+    if (!renderer.Render(options.params, precision))
+        return false;
+
+    for (int device = 0; device < renderer.GetDeviceCount(); device++)
+    {
+        std::cout << renderer.GetDeviceName(device) << ": " << renderer.GetKernelTime(device) << " ms, next share "
+            << renderer.GetShare(device) * 100.0 << "%\n";
+    }
+
+    if (options.params.filterOn && !renderer.Filter())
+        return false;
+
+    return WritePng(options.output, options.width, options.height, renderer.GetPixels());
+}
+
+bool RunHeadless(const Options& options)
+{
+    Palette palette;
+    if (!options.palette.empty() && !palette.Find(options.palette))
+        return false;
+
+    if (!options.sequence.empty())
+        return RunSequence(options, palette);
+    if (options.cpuCheck)
+        return CompareBackends(options, palette);
+    if (!options.cpu)
+    {
+        HeadlessRenderer renderer(options.width, options.height);
+        if (renderer.Init(options.params, options.device) && renderer.SetPalette(palette))
+        {
+            // Like split frames in the window, deep zoom views keep the single device path
+            if (options.multiDevice)
+            {
+                if (!options.params.deepZoom && options.centerRe.empty() &&
+                    renderer.GetVariants().Select(options.params, options.width) != Precision::Perturbation)
+                    return RenderSplit(options, palette);
+
+                std::cout << "Deep zoom views are not split, rendering on one device\n";
+            }
+
+            if (options.centerRe.empty())
+                renderer.GetDeepZoom().SetCenter(options.params.dx, options.params.dy);
+            else
+                renderer.GetDeepZoom().SetCenter(options.centerRe, options.centerIm);
+
+            return renderer.Render(options.params) && renderer.WriteImage(options.output);
+        }
+
+        std::cout << "No usable OpenCL device, falling back to the CPU renderer\n";
+    }
+
+    if (options.params.deepZoom)
+        std::cout << "CPU renderer iterates in float precision only\n";
+
+    CpuRenderer renderer(options.width, options.height);
+    const CpuKernel kernel = options.basic ? CpuKernel::Mandel : CpuKernel::MandelSmooth;
+    if (!renderer.Init(options.isa, options.threads, options.tileSize))
+        return false;
+    renderer.SetPalette(palette);
+    return renderer.Render(options.params, kernel) && renderer.WriteImage(options.output);
+}
+
+bool WritePng(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels)
+{
+    if (!stbi_write_png(path.c_str(), width, height, 4, &pixels[0], width * 4))
+    {
+        std::cout << "Error writing " << path << std::endl;
+        return false;
+    }
+
+    std::cout << "Wrote " << path << std::endl;
+    return true;
+}
+
+bool HeadlessRenderer::WriteImage(const std::string& path) const
+{
+    return WritePng(path, m_width, m_height, m_pixels);
+}
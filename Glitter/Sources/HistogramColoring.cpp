@@ -0,0 +1,111 @@
+#include "HistogramColoring.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+// Largest power of two work-group size the kernel can run with, capped
+static int GetGroupSize(const cl::Kernel& kernel, const cl::Device& device, int cap)
+{
+    const size_t limit = std::min<size_t>(kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device), (size_t)cap);
+    int size = 1;
+    while ((size_t)size * 2 <= limit)
+        size *= 2;
+    return size;
+}
+
+HistogramColoring::HistogramColoring()
+    :
+    m_width(0),
+    m_height(0),
+    m_groups(0),
+    m_localSize(1),
+    m_scanSize(1)
+{
+}
+
+bool HistogramColoring::Init(const cl::Context& context, const cl::Device& device, const cl::Program& program, int width, int height)
+{
+    m_device = device;
+    m_width = width;
+    m_height = height;
+
+    // A few work-groups per compute unit keep every unit busy; each writes one partial histogram
+    m_groups = std::min(std::max((int)device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() * 4, 1), 256);
+
+    cl_int err = CL_SUCCESS;
+    m_partials = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_int) * maxBins * m_groups, NULL, &err);
+    if (err == CL_SUCCESS)
+        m_histogram = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_int) * maxBins, NULL, &err);
+    if (err == CL_SUCCESS)
+        m_cdf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_int) * maxBins, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating histogram buffers" << " " << err << "\n";
+        return false;
+    }
+
+    return SetProgram(program);
+}
+
+bool HistogramColoring::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_localKernel = cl::Kernel(program, "HistogramLocal", &err);
+    if (err == CL_SUCCESS)
+        m_mergeKernel = cl::Kernel(program, "HistogramMerge", &err);
+    if (err == CL_SUCCESS)
+        m_scanKernel = cl::Kernel(program, "HistogramScan", &err);
+    if (err == CL_SUCCESS)
+        m_colorKernel = cl::Kernel(program, "ColorHistogram", &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating histogram kernels" << " " << err << "\n";
+        return false;
+    }
+
+    m_localSize = GetGroupSize(m_localKernel, m_device, maxGroupSize);
+    m_scanSize = GetGroupSize(m_scanKernel, m_device, maxGroupSize);
+
+    Resize(m_width, m_height);
+    m_localKernel.setArg(2, cl::Local(sizeof(cl_int) * maxBins));
+    m_localKernel.setArg(3, m_partials);
+    m_mergeKernel.setArg(0, m_partials);
+    m_mergeKernel.setArg(1, (cl_int)m_groups);
+    m_mergeKernel.setArg(2, m_histogram);
+    m_scanKernel.setArg(0, m_histogram);
+    m_scanKernel.setArg(1, cl::Local(sizeof(cl_int) * m_scanSize));
+    m_scanKernel.setArg(2, m_cdf);
+    m_colorKernel.setArg(2, m_cdf);
+
+    return true;
+}
+
+void HistogramColoring::Resize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_localKernel.setArg(1, (cl_int)(width * height));
+    m_colorKernel.setArg(5, (cl_int)width);
+}
+
+bool HistogramColoring::Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer& samples,
+    const SampleColoring& coloring, const Params& params)
+{
+    m_localKernel.setArg(0, samples);
+    m_colorKernel.setArg(0, image);
+    m_colorKernel.setArg(1, samples);
+    m_colorKernel.setArg(3, coloring.GetPalette());
+    m_colorKernel.setArg(4, params.exposure);
+
+    cl_int err = queue.enqueueNDRangeKernel(m_localKernel, cl::NullRange, cl::NDRange(m_groups * m_localSize), cl::NDRange(m_localSize));
+    if (err == CL_SUCCESS)
+        err = queue.enqueueNDRangeKernel(m_mergeKernel, cl::NullRange, cl::NDRange(maxBins));
+    if (err == CL_SUCCESS)
+        err = queue.enqueueNDRangeKernel(m_scanKernel, cl::NullRange, cl::NDRange(m_scanSize), cl::NDRange(m_scanSize));
+    if (err == CL_SUCCESS)
+        err = queue.enqueueNDRangeKernel(m_colorKernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing histogram coloring" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,64 @@
+#include "IterationStats.hpp"
+
+#include <iostream>
+
+IterationStats::IterationStats()
+    :
+    m_readPending(false)
+{
+    m_counts[0] = 0;
+    m_counts[1] = 0;
+    m_readback[0] = 0;
+    m_readback[1] = 0;
+}
+
+bool IterationStats::Init(const cl::Context& context)
+{
+    cl_int err = CL_SUCCESS;
+    m_buffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(m_counts), NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating iteration stats buffer" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool IterationStats::Reset(const cl::CommandQueue& queue)
+{
+    const cl_int zero = 0;
+    const cl_int err = queue.enqueueFillBuffer(m_buffer, zero, 0, sizeof(m_counts));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error resetting iteration stats" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool IterationStats::Read(const cl::CommandQueue& queue, bool blocking)
+{
+    cl_int err = CL_SUCCESS;
+    if (blocking)
+        err = queue.enqueueReadBuffer(m_buffer, CL_TRUE, 0, sizeof(m_counts), m_counts);
+    else
+        err = queue.enqueueReadBuffer(m_buffer, CL_FALSE, 0, sizeof(m_readback), m_readback, NULL, &m_readEvent);
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error reading iteration stats" << " " << err << "\n";
+        return false;
+    }
+
+    m_readPending = !blocking;
+    return true;
+}
+
+void IterationStats::Update()
+{
+    if (!m_readPending || m_readEvent.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE)
+        return;
+
+    m_counts[0] = m_readback[0];
+    m_counts[1] = m_readback[1];
+    m_readPending = false;
+}
@@ -0,0 +1,172 @@
+#include "MandelVariants.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+// Relative rounding error of each arithmetic; double-single is taken conservatively at 44 bits
+static const double floatEpsilon = FLT_EPSILON;
+static const double dsEpsilon = 5.7e-14;
+static const double doubleEpsilon = DBL_EPSILON;
+
+// Width of the view at scale 1, must match xMinMax in mandel.cl
+static const double viewWidth = 0.47 + 2.0;
+
+const char* PrecisionName(Precision precision)
+{
+    switch (precision)
+    {
+    case Precision::Float:
+        return "float";
+    case Precision::DoubleSingle:
+        return "double-single";
+    case Precision::Double:
+        return "double";
+    case Precision::Perturbation:
+        return "perturbation";
+    }
+
+    return "unknown";
+}
+
+MandelVariants::MandelVariants()
+    :
+    m_hasFp64(false),
+    m_isGpu(false)
+{
+}
+
+bool MandelVariants::Init(const cl::Device& device, const cl::Program& program, const cl::Buffer& earlyExits)
+{
+    m_earlyExits = earlyExits;
+    m_hasFp64 = device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_fp64") != std::string::npos;
+    m_isGpu = (device.getInfo<CL_DEVICE_TYPE>() & CL_DEVICE_TYPE_GPU) != 0;
+
+    return SetProgram(program);
+}
+
+bool MandelVariants::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_floatKernel = cl::Kernel(program, "MandelSmooth", &err);
+    if (err == CL_SUCCESS)
+        m_dsKernel = cl::Kernel(program, "MandelSmoothDS", &err);
+    if (err == CL_SUCCESS && m_hasFp64)
+        m_doubleKernel = cl::Kernel(program, "MandelSmoothF64", &err);
+    if (err == CL_SUCCESS)
+        m_distanceKernel = cl::Kernel(program, "MandelSmoothDE", &err);
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating MandelSmooth variants" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+Precision MandelVariants::Select(const Params& params, int width) const
+{
+    if (params.deepZoom)
+        return Precision::Perturbation;
+    if (!params.autoPrecision)
+        return Precision::Float;
+
+    return SelectForSpacing(viewWidth / (width * params.scale), params.dx, params.dy);
+}
+
+Precision MandelVariants::SelectForSpacing(double spacing, double dx, double dy) const
+{
+    // A variant resolves the samples when its rounding error at the coordinate magnitude
+    // stays a few times below their spacing
+    const double magnitude = std::max(std::max(std::fabs(dx), std::fabs(dy)), 2.0);
+    const double required = spacing / (magnitude * 4.0);
+
+    if (required > floatEpsilon)
+        return Precision::Float;
+
+    // Consumer GPUs run fp64 at a small fraction of the float rate, where double-single is cheaper
+    if ((m_isGpu || !m_hasFp64) && required > dsEpsilon)
+        return Precision::DoubleSingle;
+    if (m_hasFp64 && required > doubleEpsilon)
+        return Precision::Double;
+
+    return Precision::Perturbation;
+}
+
+bool MandelVariants::Render(const cl::CommandQueue& queue, const cl::Buffer& samples, int width, int height,
+    const Params& params, Precision precision, const RenderPass& pass, cl::Event* event)
+{
+    cl::Kernel* kernel = &m_floatKernel;
+
+    if (precision == Precision::Double && m_hasFp64)
+    {
+        kernel = &m_doubleKernel;
+        kernel->setArg(1, (cl_double)params.dx);
+        kernel->setArg(2, (cl_double)params.dy);
+        kernel->setArg(3, (cl_double)params.scale);
+    }
+    else if (precision == Precision::DoubleSingle || precision == Precision::Double)
+    {
+        // Split the offsets into hi + lo floats
+        cl_float2 dx;
+        cl_float2 dy;
+        dx.s[0] = (cl_float)params.dx;
+        dx.s[1] = (cl_float)(params.dx - dx.s[0]);
+        dy.s[0] = (cl_float)params.dy;
+        dy.s[1] = (cl_float)(params.dy - dy.s[0]);
+
+        kernel = &m_dsKernel;
+        kernel->setArg(1, dx);
+        kernel->setArg(2, dy);
+        kernel->setArg(3, (cl_float)params.scale);
+    }
+    else
+    {
+        kernel->setArg(1, (cl_float)params.dx);
+        kernel->setArg(2, (cl_float)params.dy);
+        kernel->setArg(3, (cl_float)params.scale);
+    }
+
+    cl_int2 size;
+    size.s[0] = width;
+    size.s[1] = height;
+    kernel->setArg(0, size);
+    kernel->setArg(4, samples);
+    kernel->setArg(5, pass.step);
+    kernel->setArg(6, pass.prevStep);
+    kernel->setArg(7, params.GetPeriodCheck());
+    kernel->setArg(8, m_earlyExits);
+    const cl_int err = queue.enqueueNDRangeKernel(*kernel, pass.GetOffset(), pass.GetGlobal(width, height), cl::NullRange, NULL, event);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing MandelSmooth" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool MandelVariants::RenderDistance(const cl::CommandQueue& queue, const cl::Buffer& samples, const cl::Buffer& distance, int width, int height,
+    const Params& params, const RenderPass& pass, cl::Event* event)
+{
+    cl_int2 size;
+    size.s[0] = width;
+    size.s[1] = height;
+    m_distanceKernel.setArg(0, size);
+    m_distanceKernel.setArg(1, (cl_float)params.dx);
+    m_distanceKernel.setArg(2, (cl_float)params.dy);
+    m_distanceKernel.setArg(3, (cl_float)params.scale);
+    m_distanceKernel.setArg(4, samples);
+    m_distanceKernel.setArg(5, distance);
+    m_distanceKernel.setArg(6, pass.step);
+    m_distanceKernel.setArg(7, pass.prevStep);
+    m_distanceKernel.setArg(8, params.GetPeriodCheck());
+    m_distanceKernel.setArg(9, m_earlyExits);
+    const cl_int err = queue.enqueueNDRangeKernel(m_distanceKernel, pass.GetOffset(), pass.GetGlobal(width, height), cl::NullRange, NULL, event);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing MandelSmoothDE" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,194 @@
+#include "MarianiSilver.hpp"
+
+#include <iostream>
+#include <vector>
+
+MarianiSilver::MarianiSilver()
+    :
+    m_width(0),
+    m_height(0),
+    m_tileCapacity(0),
+    m_rootCount(0),
+    m_filledFraction(0.0f)
+{
+}
+
+bool MarianiSilver::Init(const cl::Context& context, const cl::Program& program, int width, int height, const cl::Buffer& earlyExits)
+{
+    cl_int err = CL_SUCCESS;
+    m_context = context;
+    m_earlyExits = earlyExits;
+
+    if (!SetProgram(program))
+        return false;
+
+    m_counts = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(cl_int) * 3, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating Mariani-Silver renderer" << " " << err << "\n";
+        return false;
+    }
+
+    return Resize(width, height);
+}
+
+bool MarianiSilver::Resize(int width, int height)
+{
+    cl_int err = CL_SUCCESS;
+    m_width = width;
+    m_height = height;
+
+    // Any level holds at most as many tiles as the minimum size grid
+    const size_t tiles = (size_t)((width + minTileSize - 1) / minTileSize) * ((height + minTileSize - 1) / minTileSize);
+    if (tiles > m_tileCapacity)
+    {
+        const size_t capacity = sizeof(cl_int2) * tiles;
+        for (int i = 0; i < 2 && err == CL_SUCCESS; i++)
+            m_levelTiles[i] = cl::Buffer(m_context, CL_MEM_READ_WRITE, capacity, NULL, &err);
+        if (err == CL_SUCCESS)
+            m_fillTiles = cl::Buffer(m_context, CL_MEM_READ_WRITE, capacity, NULL, &err);
+        if (err == CL_SUCCESS)
+            m_directTiles = cl::Buffer(m_context, CL_MEM_READ_WRITE, capacity, NULL, &err);
+
+        if (err != CL_SUCCESS) {
+            m_tileCapacity = 0;
+            std::cout << "Error creating Mariani-Silver tile queues" << " " << err << "\n";
+            return false;
+        }
+        m_tileCapacity = tiles;
+    }
+
+    // Root level covers the frame with the largest tiles
+    std::vector<cl_int2> roots;
+    for (int y = 0; y < height; y += startTileSize)
+    {
+        for (int x = 0; x < width; x += startTileSize)
+        {
+            cl_int2 tile;
+            tile.s[0] = x;
+            tile.s[1] = y;
+            roots.push_back(tile);
+        }
+    }
+    m_rootCount = (int)roots.size();
+    m_rootTiles = cl::Buffer(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_int2) * roots.size(), &roots[0], &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error uploading root tiles" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool MarianiSilver::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_borderKernel = cl::Kernel(program, "MarianiBorder", &err);
+    if (err == CL_SUCCESS)
+        m_classifyKernel = cl::Kernel(program, "MarianiClassify", &err);
+    if (err == CL_SUCCESS)
+        m_fillKernel = cl::Kernel(program, "MarianiFill", &err);
+    if (err == CL_SUCCESS)
+        m_directKernel = cl::Kernel(program, "MarianiDirect", &err);
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating Mariani-Silver kernels" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool MarianiSilver::Render(const cl::CommandQueue& queue, const cl::Buffer& samples, const Params& params)
+{
+    const cl_float dx = (cl_float)params.dx;
+    const cl_float dy = (cl_float)params.dy;
+    const cl_float scale = (cl_float)params.scale;
+    const cl_int periodCheck = params.GetPeriodCheck();
+
+    // Everything starts invalid so borders shared between levels are iterated once
+    const cl_float2 invalid = { { -1.0f, 0.0f } };
+    cl_int err = queue.enqueueFillBuffer(samples, invalid, 0, sizeof(cl_float2) * m_width * m_height);
+
+    const cl::Buffer* tiles = &m_rootTiles;
+    int next = 0;
+    int tileCount = m_rootCount;
+    int tileSize = startTileSize;
+    long long filled = 0;
+
+    while (tileCount > 0 && err == CL_SUCCESS)
+    {
+        m_borderKernel.setArg(0, *tiles);
+        m_borderKernel.setArg(1, tileSize);
+        m_borderKernel.setArg(2, m_width);
+        m_borderKernel.setArg(3, m_height);
+        m_borderKernel.setArg(4, dx);
+        m_borderKernel.setArg(5, dy);
+        m_borderKernel.setArg(6, scale);
+        m_borderKernel.setArg(7, samples);
+        m_borderKernel.setArg(8, periodCheck);
+        m_borderKernel.setArg(9, m_earlyExits);
+        err = queue.enqueueNDRangeKernel(m_borderKernel, cl::NullRange, cl::NDRange(tileCount, 4 * tileSize - 4));
+
+        const cl_int zero = 0;
+        if (err == CL_SUCCESS)
+            err = queue.enqueueFillBuffer(m_counts, zero, 0, sizeof(cl_int) * 3);
+
+        m_classifyKernel.setArg(0, *tiles);
+        m_classifyKernel.setArg(1, tileSize);
+        m_classifyKernel.setArg(2, minTileSize);
+        m_classifyKernel.setArg(3, m_width);
+        m_classifyKernel.setArg(4, m_height);
+        m_classifyKernel.setArg(5, samples);
+        m_classifyKernel.setArg(6, m_fillTiles);
+        m_classifyKernel.setArg(7, m_levelTiles[next]);
+        m_classifyKernel.setArg(8, m_directTiles);
+        m_classifyKernel.setArg(9, m_counts);
+        if (err == CL_SUCCESS)
+            err = queue.enqueueNDRangeKernel(m_classifyKernel, cl::NullRange, cl::NDRange(tileCount));
+
+        // Only the queue sizes come back to the host
+        cl_int counts[3] = { 0, 0, 0 };
+        if (err == CL_SUCCESS)
+            err = queue.enqueueReadBuffer(m_counts, CL_TRUE, 0, sizeof(counts), counts);
+
+        if (err == CL_SUCCESS && counts[0] > 0)
+        {
+            m_fillKernel.setArg(0, m_fillTiles);
+            m_fillKernel.setArg(1, tileSize);
+            m_fillKernel.setArg(2, m_width);
+            m_fillKernel.setArg(3, m_height);
+            m_fillKernel.setArg(4, samples);
+            err = queue.enqueueNDRangeKernel(m_fillKernel, cl::NullRange, cl::NDRange(counts[0], tileSize * tileSize));
+            filled += (long long)counts[0] * (tileSize - 2) * (tileSize - 2);
+        }
+
+        if (err == CL_SUCCESS && counts[2] > 0)
+        {
+            m_directKernel.setArg(0, m_directTiles);
+            m_directKernel.setArg(1, tileSize);
+            m_directKernel.setArg(2, m_width);
+            m_directKernel.setArg(3, m_height);
+            m_directKernel.setArg(4, dx);
+            m_directKernel.setArg(5, dy);
+            m_directKernel.setArg(6, scale);
+            m_directKernel.setArg(7, samples);
+            m_directKernel.setArg(8, periodCheck);
+            m_directKernel.setArg(9, m_earlyExits);
+            err = queue.enqueueNDRangeKernel(m_directKernel, cl::NullRange, cl::NDRange(counts[2], tileSize * tileSize));
+        }
+
+        // Split tiles are the next level's input
+        tiles = &m_levelTiles[next];
+        next = 1 - next;
+        tileCount = counts[1];
+        tileSize /= 2;
+    }
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error rendering Mariani-Silver frame" << " " << err << "\n";
+        return false;
+    }
+
+    m_filledFraction = (float)((double)filled / ((double)m_width * m_height));
+    return true;
+}
@@ -0,0 +1,352 @@
+#include "MultiDevice.hpp"
+#include "CLHelpers.hpp"
+#include "DeviceSelection.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+// Fewest rows a device renders, so every device keeps being measured
+static const int minRows = 8;
+
+// Weight of the latest measurement when rebalancing, below 1 to damp oscillation
+static const double rebalanceRate = 0.5;
+
+MultiDevice::MultiDevice(int width, int height)
+    :
+    m_width(width),
+    m_height(height)
+{
+}
+
+bool MultiDevice::Init(const Params& params)
+{
+    m_kernelSource = ReadFile2(GetKernelPath().c_str());
+    m_slices.clear();
+    double totalShare = 0.0;
+    for (const DeviceInfo& info : EnumerateDevices())
+    {
+        if (!info.Supports(DeviceMode::Headless))
+        {
+            std::cout << "Skipping " << info.name << ": no image support\n";
+            continue;
+        }
+
+        std::unique_ptr<Slice> slice(new Slice());
+        slice->device = info.device;
+        slice->name = info.name;
+        if (!InitSlice(*slice, params))
+            continue;
+
+        // First split by the device score, measured times take over from the second frame
+        slice->share = info.GetScore(DeviceMode::Headless);
+        totalShare += slice->share;
+        std::cout << "Split rendering on: " << slice->name << "\n";
+        m_slices.push_back(std::move(slice));
+    }
+
+    if (m_slices.empty())
+    {
+        std::cout << " No usable devices found.\n";
+        return false;
+    }
+
+    for (std::unique_ptr<Slice>& slice : m_slices)
+        slice->share = totalShare > 0.0 ? slice->share / totalShare : 1.0 / m_slices.size();
+    Partition();
+
+    Slice& first = *m_slices[0];
+    cl_int err = CL_SUCCESS;
+    m_filterKernel = cl::Kernel(*first.program, "GaussianFilter", &err);
+    if (err == CL_SUCCESS)
+        m_filterImage = cl::Image2D(first.context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_UNORM_INT8), m_width, m_height, 0, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating filter" << " " << err << "\n";
+        return false;
+    }
+
+    m_pixels.resize((size_t)m_width * m_height * 4);
+
+    return true;
+}
+
+bool MultiDevice::InitSlice(Slice& slice, const Params& params)
+{
+    cl_int err = CL_SUCCESS;
+    slice.context = cl::Context(slice.device, NULL, NULL, NULL, &err);
+    if (err == CL_SUCCESS)
+        slice.queue = cl::CommandQueue(slice.context, slice.device, CL_QUEUE_PROFILING_ENABLE, &err);
+    if (err == CL_SUCCESS)
+        slice.image = cl::Image2D(slice.context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_UNORM_INT8), m_width, m_height, 0, NULL, &err);
+    if (err == CL_SUCCESS)
+        slice.samples = cl::Buffer(slice.context, CL_MEM_READ_WRITE, sizeof(cl_float2) * m_width * m_height, NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating context for " << slice.name << " " << err << "\n";
+        return false;
+    }
+
+    slice.programCache.Init(slice.context, slice.device, m_kernelSource);
+    slice.program = slice.programCache.Get(params.maxIter, params.bailout);
+    if (slice.program == NULL || !slice.stats.Init(slice.context))
+        return false;
+
+    return slice.variants.Init(slice.device, *slice.program, slice.stats.GetBuffer()) &&
+        slice.coloring.Init(slice.context, *slice.program, m_width, m_height);
+}
+
+bool MultiDevice::Resize(int width, int height)
+{
+    if (width == m_width && height == m_height)
+        return true;
+
+    m_width = width;
+    m_height = height;
+
+    cl_int err = CL_SUCCESS;
+    for (std::unique_ptr<Slice>& slice : m_slices)
+    {
+        slice->image = cl::Image2D(slice->context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_UNORM_INT8), width, height, 0, NULL, &err);
+        if (err == CL_SUCCESS)
+            slice->samples = cl::Buffer(slice->context, CL_MEM_READ_WRITE, sizeof(cl_float2) * width * height, NULL, &err);
+        if (err != CL_SUCCESS) {
+            std::cout << "Error resizing buffers of " << slice->name << " " << err << "\n";
+            return false;
+        }
+        slice->coloring.Resize(width, height);
+    }
+
+    if (!m_slices.empty())
+    {
+        m_filterImage = cl::Image2D(m_slices[0]->context, CL_MEM_READ_WRITE, cl::ImageFormat(CL_RGBA, CL_UNORM_INT8), width, height, 0, NULL, &err);
+        if (err != CL_SUCCESS) {
+            std::cout << "Error creating filter" << " " << err << "\n";
+            return false;
+        }
+    }
+
+    m_pixels.resize((size_t)width * height * 4);
+    Partition();
+
+    return true;
+}
+
+Precision MultiDevice::Select(const Params& params) const
+{
+    Precision precision = Precision::Float;
+    for (const std::unique_ptr<Slice>& slice : m_slices)
+        precision = std::max(precision, slice->variants.Select(params, m_width));
+
+    // Devices without fp64 run double-single for a Double frame
+    return precision == Precision::Perturbation ? Precision::Double : precision;
+}
+
+bool MultiDevice::SetPalette(const Palette& palette)
+{
+    for (std::unique_ptr<Slice>& slice : m_slices)
+    {
+        if (!slice->coloring.SetPalette(palette))
+            return false;
+    }
+
+    return true;
+}
+
+bool MultiDevice::Render(const Params& params, Precision precision)
+{
+    // Enqueue every band first so the devices run concurrently
+    for (std::unique_ptr<Slice>& slice : m_slices)
+    {
+        const cl::Program* program = slice->programCache.Get(params.maxIter, params.bailout);
+        if (program == NULL)
+            return false;
+        if (program != slice->program)
+        {
+            if (!slice->variants.SetProgram(*program) || !slice->coloring.SetProgram(*program))
+                return false;
+            slice->program = program;
+        }
+
+        if (slice->rowEnd == slice->rowBegin)
+            continue;
+
+        RenderPass pass;
+        pass.rowBegin = slice->rowBegin;
+        pass.rowEnd = slice->rowEnd;
+        if (!slice->stats.Reset(slice->queue) ||
+            !slice->variants.Render(slice->queue, slice->samples, m_width, m_height, params, precision, pass, &slice->kernelEvent) ||
+            !slice->coloring.Render(slice->queue, slice->image, slice->samples, 1, params, slice->rowBegin, slice->rowEnd))
+            return false;
+        slice->queue.flush();
+    }
+
+    for (std::unique_ptr<Slice>& slice : m_slices)
+    {
+        if (slice->rowEnd == slice->rowBegin)
+            continue;
+
+        cl::size_t<3> origin;
+        cl::size_t<3> region;
+        origin[1] = slice->rowBegin;
+        region[0] = m_width;
+        region[1] = slice->rowEnd - slice->rowBegin;
+        region[2] = 1;
+        const cl_int err = slice->queue.enqueueReadImage(slice->image, CL_FALSE, origin, region, m_width * 4, 0,
+            &m_pixels[(size_t)slice->rowBegin * m_width * 4], NULL, &slice->readEvent);
+        if (err != CL_SUCCESS) {
+            std::cout << "Error reading band of " << slice->name << " " << err << "\n";
+            return false;
+        }
+        slice->queue.flush();
+    }
+
+    for (std::unique_ptr<Slice>& slice : m_slices)
+    {
+        if (slice->rowEnd == slice->rowBegin)
+        {
+            slice->kernelTime = 0.0;
+            continue;
+        }
+
+        slice->readEvent.wait();
+        slice->stats.Read(slice->queue);
+        const cl_ulong start = slice->kernelEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        const cl_ulong end = slice->kernelEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        slice->kernelTime = (end - start) * 1e-6;
+    }
+
+    Rebalance();
+    Partition();
+
+    return true;
+}
+
+bool MultiDevice::Filter()
+{
+    Slice& first = *m_slices[0];
+    cl::size_t<3> origin;
+    cl::size_t<3> region;
+    region[0] = m_width;
+    region[1] = m_height;
+    region[2] = 1;
+
+    cl_int err = first.queue.enqueueWriteImage(first.image, CL_FALSE, origin, region, m_width * 4, 0, &m_pixels[0]);
+    if (err == CL_SUCCESS)
+    {
+        m_filterKernel.setArg(0, first.image);
+        m_filterKernel.setArg(1, m_filterImage);
+        cl_int2 size;
+        size.s[0] = m_width;
+        size.s[1] = m_height;
+        m_filterKernel.setArg(2, size);
+        err = first.queue.enqueueNDRangeKernel(m_filterKernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    }
+    if (err == CL_SUCCESS)
+        err = first.queue.enqueueReadImage(m_filterImage, CL_TRUE, origin, region, m_width * 4, 0, &m_pixels[0]);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error filtering merged frame" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool MultiDevice::Upload(const cl::CommandQueue& queue, const cl::Image2D& image) const
+{
+    cl::size_t<3> origin;
+    cl::size_t<3> region;
+    region[0] = m_width;
+    region[1] = m_height;
+    region[2] = 1;
+
+    // Blocking, the next frame's bands land in the same host memory. The 1.2 bindings take
+    // a non-const pointer for writes.
+    const cl_int err = queue.enqueueWriteImage(image, CL_TRUE, origin, region, m_width * 4, 0, (void*)&m_pixels[0]);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error uploading merged frame" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+const std::string& MultiDevice::GetDeviceName(int device) const
+{
+    return m_slices[device]->name;
+}
+
+double MultiDevice::GetShare(int device) const
+{
+    return m_slices[device]->share;
+}
+
+double MultiDevice::GetKernelTime(int device) const
+{
+    return m_slices[device]->kernelTime;
+}
+
+long long MultiDevice::GetCardioidExits() const
+{
+    long long exits = 0;
+    for (const std::unique_ptr<Slice>& slice : m_slices)
+        exits += slice->stats.GetCardioidExits();
+    return exits;
+}
+
+long long MultiDevice::GetPeriodicExits() const
+{
+    long long exits = 0;
+    for (const std::unique_ptr<Slice>& slice : m_slices)
+        exits += slice->stats.GetPeriodicExits();
+    return exits;
+}
+
+void MultiDevice::Partition()
+{
+    int row = 0;
+    const int count = (int)m_slices.size();
+    for (int i = 0; i < count; i++)
+    {
+        Slice& slice = *m_slices[i];
+        slice.rowBegin = row;
+
+        if (i == count - 1)
+            slice.rowEnd = m_height;
+        else
+        {
+            // Leave at least minRows for every device after this one
+            const int maxRows = std::max(m_height - row - minRows * (count - 1 - i), 0);
+            const int rows = (int)(slice.share * m_height + 0.5);
+            slice.rowEnd = row + std::min(std::max(rows, std::min(minRows, maxRows)), maxRows);
+        }
+
+        row = slice.rowEnd;
+    }
+}
+
+void MultiDevice::Rebalance()
+{
+    // Rows per millisecond on the band each device had
+    std::vector<double> speeds(m_slices.size(), 0.0);
+    double totalSpeed = 0.0;
+    double measuredShare = 0.0;
+    for (size_t i = 0; i < m_slices.size(); i++)
+    {
+        const Slice& slice = *m_slices[i];
+        if (slice.kernelTime <= 0.0 || slice.rowEnd == slice.rowBegin)
+            continue;
+
+        speeds[i] = (slice.rowEnd - slice.rowBegin) / slice.kernelTime;
+        totalSpeed += speeds[i];
+        measuredShare += slice.share;
+    }
+
+    if (totalSpeed <= 0.0)
+        return;
+
+    // Unmeasured devices keep their share, the measured ones split the rest by speed
+    for (size_t i = 0; i < m_slices.size(); i++)
+    {
+        Slice& slice = *m_slices[i];
+        if (speeds[i] > 0.0)
+            slice.share += rebalanceRate * (measuredShare * speeds[i] / totalSpeed - slice.share);
+    }
+}
@@ -0,0 +1,215 @@
+#include "Options.hpp"
+#include <algorithm>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+Options ParseOptions(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (strcmp(arg, "--headless") == 0)
+            options.headless = true;
+        else if (strcmp(arg, "--list-devices") == 0)
+            options.listDevices = true;
+        else if (strcmp(arg, "--device") == 0 && hasValue)
+            options.device = argv[++i];
+        else if (strcmp(arg, "--multi") == 0)
+            options.multiDevice = true;
+        else if (strcmp(arg, "--cpu") == 0)
+            options.cpu = true;
+        else if (strcmp(arg, "--cpu-check") == 0)
+            options.cpuCheck = true;
+        else if (strcmp(arg, "--basic") == 0)
+            options.basic = true;
+        else if (strcmp(arg, "--isa") == 0 && hasValue)
+            options.isa = argv[++i];
+        else if (strcmp(arg, "--threads") == 0 && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if (strcmp(arg, "--tile") == 0 && hasValue)
+            options.tileSize = atoi(argv[++i]);
+        else if (strcmp(arg, "--filter") == 0)
+            options.params.filterOn = true;
+        else if (strcmp(arg, "--deep") == 0)
+            options.params.deepZoom = true;
+        else if (strcmp(arg, "--float") == 0)
+            options.params.autoPrecision = false;
+        else if (strcmp(arg, "--histogram") == 0)
+            options.params.histogram = true;
+        else if (strcmp(arg, "--de") == 0)
+            options.params.distanceEstimate = true;
+        else if (strcmp(arg, "--boundary-width") == 0 && hasValue)
+            options.params.boundaryWidth = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--aa") == 0)
+            options.params.antialias = true;
+        else if (strcmp(arg, "--aa-threshold") == 0 && hasValue)
+            options.params.antialiasThreshold = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--accumulate") == 0 && hasValue)
+        {
+            options.params.accumulateFrames = atoi(argv[++i]);
+            options.params.accumulate = true;
+        }
+        else if (strcmp(arg, "--budget") == 0 && hasValue)
+        {
+            options.params.frameBudget = std::max((float)atof(argv[++i]), minFrameBudget);
+            options.params.dynamicResolution = true;
+        }
+        else if (strcmp(arg, "--mariani") == 0)
+            options.params.mariani = true;
+        else if (strcmp(arg, "--poll") == 0)
+            options.params.idleWait = false;
+        else if (strcmp(arg, "--width") == 0 && hasValue)
+            options.width = atoi(argv[++i]);
+        else if (strcmp(arg, "--height") == 0 && hasValue)
+            options.height = atoi(argv[++i]);
+        else if (strcmp(arg, "--output") == 0 && hasValue)
+            options.output = argv[++i];
+        else if (strcmp(arg, "--dx") == 0 && hasValue)
+            options.params.dx = atof(argv[++i]);
+        else if (strcmp(arg, "--dy") == 0 && hasValue)
+            options.params.dy = atof(argv[++i]);
+        else if (strcmp(arg, "--scale") == 0 && hasValue)
+            options.params.scale = atof(argv[++i]);
+        else if (strcmp(arg, "--iter") == 0 && hasValue)
+            options.params.maxIter = atoi(argv[++i]);
+        else if (strcmp(arg, "--bailout") == 0 && hasValue)
+            options.params.bailout = atof(argv[++i]);
+        else if (strcmp(arg, "--palette") == 0 && hasValue)
+            options.palette = argv[++i];
+        else if (strcmp(arg, "--palette-offset") == 0 && hasValue)
+            options.params.paletteOffset = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--palette-density") == 0 && hasValue)
+            options.params.paletteDensity = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--exposure") == 0 && hasValue)
+            options.params.exposure = (float)atof(argv[++i]);
+        else if (strcmp(arg, "--sequence") == 0 && hasValue)
+            options.sequence = argv[++i];
+        else if (strcmp(arg, "--keyframes") == 0 && hasValue)
+            options.keyframes = argv[++i];
+        else if (strcmp(arg, "--fps") == 0 && hasValue)
+            options.fps = atoi(argv[++i]);
+        else if (strcmp(arg, "--frames") == 0 && hasValue)
+            options.frames = atoi(argv[++i]);
+        else if (strcmp(arg, "--duration") == 0 && hasValue)
+            options.duration = atof(argv[++i]);
+        else if (strcmp(arg, "--zoom-end") == 0 && hasValue)
+            options.zoomEnd = atof(argv[++i]);
+        else if (strcmp(arg, "--writers") == 0 && hasValue)
+            options.writers = atoi(argv[++i]);
+        else if (strcmp(arg, "--expmap") == 0)
+            options.expMap = true;
+        else if (strcmp(arg, "--period") == 0 && hasValue)
+        {
+            options.params.periodCheck = atoi(argv[++i]);
+            options.params.interiorChecks = options.params.periodCheck >= 0;
+        }
+        else if (strcmp(arg, "--re") == 0 && hasValue)
+        {
+            options.centerRe = argv[++i];
+            options.params.dx = atof(options.centerRe.c_str());
+            options.params.deepZoom = true;
+        }
+        else if (strcmp(arg, "--im") == 0 && hasValue)
+        {
+            options.centerIm = argv[++i];
+            options.params.dy = atof(options.centerIm.c_str());
+            options.params.deepZoom = true;
+        }
+        else if (strcmp(arg, "--help") == 0)
+        {
+            PrintUsage();
+            exit(EXIT_SUCCESS);
+        }
+        else
+            std::cout << "Ignoring unknown argument: " << arg << std::endl;
+    }
+
+    // A lone --re or --im keeps the other coordinate from --dx/--dy
+    if (options.centerRe.empty() != options.centerIm.empty())
+    {
+        char buffer[64];
+        std::string& missing = options.centerRe.empty() ? options.centerRe : options.centerIm;
+        snprintf(buffer, sizeof(buffer), "%.17f", options.centerRe.empty() ? options.params.dx : options.params.dy);
+        missing = buffer;
+    }
+
+    options.params.ClampIterations();
+    options.params.ClampColoring();
+
+    if (options.tileSize <= 0)
+    {
+        std::cout << "Invalid tile size, using 32" << std::endl;
+        options.tileSize = 32;
+    }
+
+    if (options.fps <= 0)
+    {
+        std::cout << "Invalid frame rate, using 30" << std::endl;
+        options.fps = 30;
+    }
+
+    if (options.width <= 0 || options.height <= 0)
+    {
+        std::cout << "Invalid resolution, using 1920x1080" << std::endl;
+        options.width = 1920;
+        options.height = 1080;
+    }
+
+    return options;
+}
+
+void PrintUsage()
+{
+    std::cout << "Usage: Mandelbrot [options]\n"
+        "  --headless          render one frame without a window and exit\n"
+        "  --device X          OpenCL device by index or part of its name (default: best score)\n"
+        "  --list-devices      print the OpenCL devices with their capabilities and scores\n"
+        "  --multi             split frames over every OpenCL device, rebalanced by measured kernel time\n"
+        "  --cpu               render on the CPU (headless), also the fallback without OpenCL\n"
+        "  --isa NAME          CPU instruction set: scalar, sse2, avx2, avx512 or neon (default: widest)\n"
+        "  --basic             CPU backend renders the basic Mandel coloring\n"
+        "  --threads N         CPU worker threads (default: all cores)\n"
+        "  --tile N            CPU tile edge in pixels (default 32)\n"
+        "  --cpu-check         render in float on both backends and compare (headless)\n"
+        "  --width N           output width (headless)\n"
+        "  --height N          output height (headless)\n"
+        "  --output FILE       output PNG path (headless)\n"
+        "  --dx X              horizontal offset\n"
+        "  --dy Y              vertical offset\n"
+        "  --scale S           zoom scale\n"
+        "  --iter N            iteration limit (default 1000)\n"
+        "  --bailout R         escape radius (default 256)\n"
+        "  --filter            apply the gaussian filter\n"
+        "  --deep              perturbation deep zoom renderer\n"
+        "  --float             always iterate in float instead of picking the precision by zoom\n"
+        "  --histogram         histogram-equalized coloring\n"
+        "  --de                distance estimation, shades escaped pixels near the set (float views)\n"
+        "  --boundary-width X  pixels over which --de fades to black near the set, 0 for none (default 1)\n"
+        "  --aa                adaptive anti-aliasing of high-contrast pixels (float views)\n"
+        "  --aa-threshold X    color difference across a pixel's neighborhood that gets refined (default 0.1)\n"
+        "  --accumulate N      blend N jittered samples per pixel (float views; interactive: while the view is still)\n"
+        "  --budget MS         dynamic resolution: moving views keep the kernel within MS milliseconds (default 16)\n"
+        "  --palette NAME      built-in palette (classic, ultra, gray), palette file or name in palettes/\n"
+        "  --palette-offset X  palette shift in iterations (default 0)\n"
+        "  --palette-density X palette cycles per palette period (default 1)\n"
+        "  --exposure X        color brightness scale (default 1)\n"
+        "  --sequence OUT      render a zoom video (headless) to a .y4m stream or PNG frames such as frame_%05d.png\n"
+        "  --keyframes FILE    zoom path, one \"time dx dy scale\" line per keyframe\n"
+        "  --duration S        seconds of the zoom into dx/dy without keyframes (default 10)\n"
+        "  --zoom-end S        scale the zoom ends at without keyframes (default 1000 times --scale)\n"
+        "  --fps N             sequence frame rate (default 30)\n"
+        "  --frames N          sequence frame count (default duration * fps + 1)\n"
+        "  --writers N         PNG encoder threads (default: all cores but one)\n"
+        "  --expmap            resample sequence frames from one exponential map strip (straight zooms)\n"
+        "  --mariani           Mariani-Silver tile subdivision (float precision views)\n"
+        "  --poll              keep the loop running instead of sleeping while the view is unchanged\n"
+        "  --period N          periodicity check window, 0 = cardioid/bulb test only, < 0 = no interior checks\n"
+        "  --re X, --im Y      deep zoom reference point as full precision decimals" << std::endl;
+}
@@ -0,0 +1,293 @@
+#include "Palette.hpp"
+#include "CLHelpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <stb_image.h>
+
+namespace
+{
+    cl_float4 MakeColor(float r, float g, float b)
+    {
+        cl_float4 color;
+        color.s[0] = r / 255.0f;
+        color.s[1] = g / 255.0f;
+        color.s[2] = b / 255.0f;
+        color.s[3] = 1.0f;
+        return color;
+    }
+
+    cl_float4 Lerp(const cl_float4& a, const cl_float4& b, float t)
+    {
+        cl_float4 color;
+        for (int c = 0; c < 4; c++)
+            color.s[c] = (1.0f - t) * a.s[c] + t * b.s[c];
+        return color;
+    }
+
+    // Evenly spaced stops, one per color
+    std::vector<float> EvenPositions(size_t count)
+    {
+        std::vector<float> positions(count);
+        for (size_t i = 0; i < count; i++)
+            positions[i] = (float)i / count;
+        return positions;
+    }
+}
+
+Palette::Palette()
+    :
+    m_period(1.0f)
+{
+    SetBuiltin(GetBuiltinNames()[0]);
+}
+
+std::vector<std::string> Palette::GetBuiltinNames()
+{
+    std::vector<std::string> names;
+    names.push_back("classic");
+    names.push_back("ultra");
+    names.push_back("gray");
+    return names;
+}
+
+bool Palette::SetBuiltin(const std::string& name)
+{
+    std::vector<cl_float4> colors;
+    std::vector<float> positions;
+    float period = 0.0f;
+
+    if (name == "classic")
+    {
+        // The palette MandelSmooth had built in, one color per iteration
+        static const float cols[16][3] = {
+            { 66, 30, 15 },
+            { 25, 7, 26 },
+            { 9, 1, 47 },
+            { 4, 4, 73 },
+            { 0, 7, 100 },
+            { 12, 44, 138 },
+            { 24, 82, 177 },
+            { 57, 125, 209 },
+            { 134, 181, 229 },
+            { 211, 236, 248 },
+            { 241, 233, 191 },
+            { 248, 201, 95 },
+            { 255, 170, 0 },
+            { 204, 128, 0 },
+            { 153, 87, 0 },
+            { 106, 52, 3 }
+        };
+        for (int i = 0; i < 16; i++)
+            colors.push_back(MakeColor(cols[i][0], cols[i][1], cols[i][2]));
+        positions = EvenPositions(colors.size());
+        period = 16.0f;
+    }
+    else if (name == "ultra")
+    {
+        // Gradient with uneven stops that used to sit unused in mandel.cl
+        static const float pos[] = { 0.0f, 0.16f, 0.42f, 0.6425f, 0.8575f };
+        static const float col[5][3] = {
+            { 0, 7, 100 },
+            { 32, 107, 203 },
+            { 237, 255, 255 },
+            { 255, 170, 0 },
+            { 0, 2, 0 }
+        };
+        for (int i = 0; i < 5; i++)
+        {
+            positions.push_back(pos[i]);
+            colors.push_back(MakeColor(col[i][0], col[i][1], col[i][2]));
+        }
+        period = 32.0f;
+    }
+    else if (name == "gray")
+    {
+        colors.push_back(MakeColor(0, 0, 0));
+        colors.push_back(MakeColor(255, 255, 255));
+        positions = EvenPositions(colors.size());
+        period = 32.0f;
+    }
+    else
+        return false;
+
+    m_name = name;
+    SetStops(positions, colors, period);
+    return true;
+}
+
+bool Palette::Load(const std::string& path)
+{
+    std::vector<float> positions;
+    std::vector<cl_float4> colors;
+    float period = 0.0f;
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (pixels != NULL)
+    {
+        const unsigned char* row = pixels + (size_t)(height / 2) * width * 4;
+        for (int x = 0; x < width; x++)
+            colors.push_back(MakeColor(row[4 * x], row[4 * x + 1], row[4 * x + 2]));
+        stbi_image_free(pixels);
+        positions = EvenPositions(colors.size());
+    }
+    else
+    {
+        std::ifstream file(path.c_str());
+        if (!file) {
+            std::cout << "Error opening palette " << path << "\n";
+            return false;
+        }
+
+        bool positioned = false;
+        std::string line;
+        for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+        {
+            std::istringstream stream(line);
+            std::string first;
+            if (!(stream >> first) || first[0] == '#')
+                continue;
+
+            if (first == "period")
+            {
+                stream >> period;
+                continue;
+            }
+
+            std::vector<float> values(1, (float)atof(first.c_str()));
+            float value = 0.0f;
+            while (stream >> value)
+                values.push_back(value);
+
+            if (values.size() == 4)
+            {
+                positioned = true;
+                positions.push_back(values[0] - std::floor(values[0]));
+                colors.push_back(MakeColor(values[1], values[2], values[3]));
+            }
+            else if (values.size() == 3)
+                colors.push_back(MakeColor(values[0], values[1], values[2]));
+            else {
+                std::cout << "Error in palette " << path << " line " << lineNumber << "\n";
+                return false;
+            }
+        }
+
+        // Mixing both kinds of lines has no meaning
+        if (positioned && positions.size() != colors.size()) {
+            std::cout << "Error in palette " << path << ": every color needs a position or none does\n";
+            return false;
+        }
+        if (!positioned)
+            positions = EvenPositions(colors.size());
+    }
+
+    if (colors.empty()) {
+        std::cout << "Error palette " << path << " has no colors\n";
+        return false;
+    }
+
+    m_name = path;
+    SetStops(positions, colors, period > 0.0f ? period : (float)colors.size());
+    return true;
+}
+
+bool Palette::Find(const std::string& nameOrPath)
+{
+    if (SetBuiltin(nameOrPath))
+        return true;
+    if (std::ifstream(nameOrPath.c_str()))
+        return Load(nameOrPath);
+
+    const std::string shipped = GetKernelPath(("palettes/" + nameOrPath + ".pal").c_str());
+    if (std::ifstream(shipped.c_str()) && Load(shipped))
+    {
+        m_name = nameOrPath;
+        return true;
+    }
+
+    std::cout << "Error unknown palette " << nameOrPath << "\n";
+    return false;
+}
+
+void Palette::SetStops(const std::vector<float>& positions, const std::vector<cl_float4>& colors, float period)
+{
+    std::vector<size_t> order(colors.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return positions[a] < positions[b]; });
+
+    m_positions.clear();
+    m_colors.clear();
+    for (size_t i : order)
+    {
+        m_positions.push_back(positions[i]);
+        m_colors.push_back(colors[i]);
+    }
+    m_period = period;
+}
+
+cl_float4 Palette::Evaluate(float position) const
+{
+    const size_t count = m_colors.size();
+    if (count == 1)
+        return m_colors[0];
+
+    // Stop at or before the position, the wrap segment runs from the last stop to the first
+    size_t i = count - 1;
+    for (size_t s = 0; s < count; s++)
+    {
+        if (m_positions[s] <= position)
+            i = s;
+    }
+
+    const size_t next = (i + 1) % count;
+    const float start = m_positions[i];
+    const float end = next == 0 ? m_positions[0] + 1.0f : m_positions[next];
+    if (position < start)
+        position += 1.0f;
+
+    const float t = end > start ? (position - start) / (end - start) : 0.0f;
+    return Lerp(m_colors[i], m_colors[next], t);
+}
+
+std::vector<cl_float4> Palette::Bake(int entries) const
+{
+    std::vector<cl_float4> lut(entries);
+    for (int i = 0; i < entries; i++)
+        lut[i] = Evaluate((i + 0.5f) / entries);
+    return lut;
+}
+
+cl_float4 Palette::Sample(const std::vector<cl_float4>& lut, float u, bool repeat)
+{
+    const int size = (int)lut.size();
+    if (repeat)
+        u -= std::floor(u);
+
+    // Texel centers sit at (i + 0.5) / size
+    const float coord = u * size - 0.5f;
+    const float base = std::floor(coord);
+    int i0 = (int)base;
+    int i1 = i0 + 1;
+    if (repeat)
+    {
+        i0 = (i0 % size + size) % size;
+        i1 = i1 % size;
+    }
+    else
+    {
+        i0 = std::min(std::max(i0, 0), size - 1);
+        i1 = std::min(std::max(i1, 0), size - 1);
+    }
+
+    return Lerp(lut[i0], lut[i1], coord - base);
+}
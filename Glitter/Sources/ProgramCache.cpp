@@ -0,0 +1,192 @@
+#include "ProgramCache.hpp"
+#include "CLHelpers.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+// 64-bit FNV-1a, enough to tell kernel sources and cache keys apart
+static unsigned long long HashString(const std::string& text)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < text.length(); i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// Cached binaries live next to the executable, one file per key
+static std::string GetBinaryPath(const std::string& key)
+{
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "mandel_%016llx.clbin", HashString(key));
+    return GetKernelPath(file_name);
+}
+
+ProgramCache::ProgramCache()
+    :
+    m_binaryHits(0)
+{
+}
+
+void ProgramCache::Init(const cl::Context& context, const cl::Device& device, const std::string& source)
+{
+    m_context = context;
+    m_device = device;
+    m_source = source;
+    m_programs.clear();
+    m_binaryHits = 0;
+}
+
+const cl::Program* ProgramCache::Get(int maxIter, double bailout)
+{
+    const std::string options = GetBuildOptions(maxIter, bailout);
+    std::map<std::string, cl::Program>::const_iterator found = m_programs.find(options);
+    if (found != m_programs.end())
+        return &found->second;
+
+    const std::string key = GetCacheKey(options);
+    cl::Program program;
+    if (LoadBinary(key, options, program))
+    {
+        m_binaryHits++;
+        return &(m_programs[options] = program);
+    }
+
+    cl::Program::Sources sources;
+    sources.push_back({ m_source.c_str(), m_source.length() });
+    program = cl::Program(m_context, sources);
+
+    std::cout << "Building program with " << options << "\n";
+    if (program.build({ m_device }, options.c_str()) != CL_SUCCESS)
+    {
+        std::cout << " Error building: " << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(m_device) << "\n";
+        return NULL;
+    }
+
+    SaveBinary(key, program);
+    return &(m_programs[options] = program);
+}
+
+std::string ProgramCache::GetBuildOptions(int maxIter, double bailout)
+{
+    // The kernels compare against the squared radius; exponent notation keeps it a valid float literal
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "-D MAX_ITER=%d -D BAILOUT=%.9ef", maxIter, bailout * bailout);
+    return buffer;
+}
+
+std::string ProgramCache::GetCacheKey(const std::string& options) const
+{
+    char sourceHash[32];
+    snprintf(sourceHash, sizeof(sourceHash), "%016llx", HashString(m_source));
+
+    std::string key = m_device.getInfo<CL_DEVICE_NAME>();
+    key += "|";
+    key += m_device.getInfo<CL_DRIVER_VERSION>();
+    key += "|";
+    key += options;
+    key += "|";
+    key += sourceHash;
+    return key;
+}
+
+bool ProgramCache::LoadBinary(const std::string& key, const std::string& options, cl::Program& program) const
+{
+    std::ifstream file(GetBinaryPath(key).c_str(), std::ios::binary);
+    if (!file)
+        return false;
+
+    // Layout: key length, key, binary size, binary
+    unsigned int keyLength = 0;
+    file.read((char*)&keyLength, sizeof(keyLength));
+    if (!file || keyLength != key.length())
+        return false;
+    std::string storedKey(keyLength, '\0');
+    if (keyLength > 0)
+        file.read(&storedKey[0], keyLength);
+    unsigned long long binarySize = 0;
+    file.read((char*)&binarySize, sizeof(binarySize));
+    if (!file || storedKey != key || binarySize == 0)
+        return false;
+
+    // A truncated or corrupt header must not size the allocation
+    const std::streampos binaryStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff remaining = file.tellg() - binaryStart;
+    file.seekg(binaryStart);
+    if (!file || remaining < 0 || binarySize != (unsigned long long)remaining)
+        return false;
+
+    std::vector<unsigned char> binary((size_t)binarySize);
+    file.read((char*)&binary[0], binary.size());
+    if (!file)
+        return false;
+
+    cl::Program::Binaries binaries;
+    binaries.push_back(std::make_pair((const void*)&binary[0], binary.size()));
+    std::vector<cl::Device> devices(1, m_device);
+    cl_int err = CL_SUCCESS;
+    program = cl::Program(m_context, devices, binaries, NULL, &err);
+    if (err != CL_SUCCESS || program.build(devices, options.c_str()) != CL_SUCCESS)
+    {
+        std::cout << "Cached program binary rejected, building from source\n";
+        return false;
+    }
+
+    std::cout << "Loaded cached program for " << options << "\n";
+    return true;
+}
+
+void ProgramCache::SaveBinary(const std::string& key, const cl::Program& program) const
+{
+    size_t binarySize = 0;
+    cl_int err = clGetProgramInfo(program(), CL_PROGRAM_BINARY_SIZES, sizeof(binarySize), &binarySize, NULL);
+    if (err != CL_SUCCESS || binarySize == 0)
+        return;
+
+    std::vector<unsigned char> binary(binarySize);
+    unsigned char* binaryPointer = &binary[0];
+    err = clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(binaryPointer), &binaryPointer, NULL);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error reading program binary" << " " << err << "\n";
+        return;
+    }
+
+    // Render farm jobs may build the same program at once: each writes its own file and
+    // renames it into place, so a reader never sees a half written binary
+    const std::string path = GetBinaryPath(key);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", (int)getpid());
+    const std::string tempPath = path + suffix;
+
+    std::ofstream file(tempPath.c_str(), std::ios::binary);
+    const unsigned int keyLength = (unsigned int)key.length();
+    const unsigned long long size = binarySize;
+    file.write((const char*)&keyLength, sizeof(keyLength));
+    file.write(key.c_str(), keyLength);
+    file.write((const char*)&size, sizeof(size));
+    file.write((const char*)&binary[0], binary.size());
+    file.close();
+    if (!file)
+    {
+        std::cout << "Error writing program binary " << tempPath << std::endl;
+        std::remove(tempPath.c_str());
+        return;
+    }
+
+    // Fails on Windows when another job got there first, its binary is just as good
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        std::remove(tempPath.c_str());
+}
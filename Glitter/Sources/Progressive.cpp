@@ -0,0 +1,37 @@
+#include "Progressive.hpp"
+
+// 1/16, 1/4 and all of the pixels
+const int ProgressiveRenderer::steps[ProgressiveRenderer::passCount] = { 4, 2, 1 };
+
+ProgressiveRenderer::ProgressiveRenderer()
+    :
+    m_pass(0),
+    m_started(false)
+{
+}
+
+bool ProgressiveRenderer::NextPass(const Params& params, RenderPass& pass)
+{
+    if (!m_started || !params.SameView(m_lastParams))
+    {
+        m_lastParams = params;
+        m_pass = 0;
+        m_started = true;
+    }
+
+    if (m_pass >= passCount)
+        return false;
+
+    pass.step = steps[m_pass];
+    pass.prevStep = m_pass > 0 ? steps[m_pass - 1] : 0;
+    m_pass++;
+
+    return true;
+}
+
+void ProgressiveRenderer::Complete(const Params& params)
+{
+    m_lastParams = params;
+    m_pass = passCount;
+    m_started = true;
+}
@@ -0,0 +1,47 @@
+#include "RenderTargets.hpp"
+
+// Longer than the gap between resize events of a drag, short enough to feel immediate after it
+static const double settleTime = 0.2;
+
+RenderTargets::RenderTargets()
+    :
+    m_width(0),
+    m_height(0),
+    m_pendingWidth(0),
+    m_pendingHeight(0),
+    m_changeTime(0.0)
+{
+}
+
+void RenderTargets::Init(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_pendingWidth = width;
+    m_pendingHeight = height;
+}
+
+bool RenderTargets::Update(int framebufferWidth, int framebufferHeight, double time)
+{
+    if (framebufferWidth <= 0 || framebufferHeight <= 0)
+        return false;
+
+    if (framebufferWidth != m_pendingWidth || framebufferHeight != m_pendingHeight)
+    {
+        m_pendingWidth = framebufferWidth;
+        m_pendingHeight = framebufferHeight;
+        m_changeTime = time;
+    }
+
+    if (!IsPending() || time - m_changeTime < settleTime)
+        return false;
+
+    m_width = m_pendingWidth;
+    m_height = m_pendingHeight;
+    return true;
+}
+
+double RenderTargets::GetSettleTime()
+{
+    return settleTime;
+}
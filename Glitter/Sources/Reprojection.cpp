@@ -0,0 +1,129 @@
+#include "Reprojection.hpp"
+
+#include <cmath>
+#include <iostream>
+
+// View size at scale 1, must match xMinMax and yMinMax in mandel.cl
+static const double viewWidth = 0.47 + 2.0;
+static const double viewHeight = 1.12 + 1.12;
+
+ReprojectionCache::ReprojectionCache()
+    :
+    m_width(0),
+    m_height(0),
+    m_capacity(0),
+    m_current(0),
+    m_valid(false),
+    m_cachedPrecision(Precision::Float)
+{
+}
+
+bool ReprojectionCache::Init(const cl::Context& context, const cl::Program& program, int width, int height)
+{
+    cl_int err = CL_SUCCESS;
+    m_context = context;
+
+    m_kernel = cl::Kernel(program, "Reproject", &err);
+    if (err == CL_SUCCESS)
+        m_distanceKernel = cl::Kernel(program, "ReprojectDistance", &err);
+
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating reprojection kernels" << " " << err << "\n";
+        return false;
+    }
+
+    return Resize(width, height);
+}
+
+bool ReprojectionCache::Resize(int width, int height)
+{
+    cl_int err = CL_SUCCESS;
+    m_width = width;
+    m_height = height;
+    m_current = 0;
+    m_valid = false;
+
+    const size_t pixels = (size_t)width * height;
+    if (pixels <= m_capacity)
+        return true;
+
+    for (int i = 0; i < 2 && err == CL_SUCCESS; i++)
+    {
+        m_samples[i] = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(cl_float2) * pixels, NULL, &err);
+        if (err == CL_SUCCESS)
+            m_distance[i] = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(cl_float) * pixels, NULL, &err);
+    }
+
+    if (err != CL_SUCCESS) {
+        m_capacity = 0;
+        std::cout << "Error creating reprojection cache" << " " << err << "\n";
+        return false;
+    }
+
+    m_capacity = pixels;
+    return true;
+}
+
+bool ReprojectionCache::Prepare(Params& params, Precision precision, int& shiftX, int& shiftY) const
+{
+    if (!m_valid || precision != m_cachedPrecision || precision == Precision::Perturbation ||
+        params.scale != m_cachedParams.scale || params.autoPrecision != m_cachedParams.autoPrecision ||
+        params.maxIter != m_cachedParams.maxIter || params.bailout != m_cachedParams.bailout ||
+        params.distanceEstimate != m_cachedParams.distanceEstimate)
+        return false;
+
+    // Old pixel = new pixel + shift, y grows downwards while dy grows upwards
+    const double pixelsX = m_width * params.scale / viewWidth;
+    const double pixelsY = m_height * params.scale / viewHeight;
+    const double sx = std::floor((params.dx - m_cachedParams.dx) * pixelsX + 0.5);
+    const double sy = std::floor((params.dy - m_cachedParams.dy) * pixelsY + 0.5);
+    if (std::fabs(sx) >= m_width || std::fabs(sy) >= m_height)
+        return false;
+
+    params.dx = m_cachedParams.dx + sx / pixelsX;
+    params.dy = m_cachedParams.dy + sy / pixelsY;
+    shiftX = (int)sx;
+    shiftY = -(int)sy;
+
+    return true;
+}
+
+bool ReprojectionCache::Reproject(const cl::CommandQueue& queue, int shiftX, int shiftY)
+{
+    if (shiftX == 0 && shiftY == 0)
+        return true;
+
+    const int next = 1 - m_current;
+    m_kernel.setArg(0, m_samples[m_current]);
+    m_kernel.setArg(1, m_samples[next]);
+    m_kernel.setArg(2, m_width);
+    m_kernel.setArg(3, m_height);
+    m_kernel.setArg(4, shiftX);
+    m_kernel.setArg(5, shiftY);
+
+    cl_int err = queue.enqueueNDRangeKernel(m_kernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    if (err == CL_SUCCESS && m_cachedParams.distanceEstimate)
+    {
+        m_distanceKernel.setArg(0, m_distance[m_current]);
+        m_distanceKernel.setArg(1, m_distance[next]);
+        m_distanceKernel.setArg(2, m_width);
+        m_distanceKernel.setArg(3, m_height);
+        m_distanceKernel.setArg(4, shiftX);
+        m_distanceKernel.setArg(5, shiftY);
+        err = queue.enqueueNDRangeKernel(m_distanceKernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    }
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing Reproject" << " " << err << "\n";
+        return false;
+    }
+
+    m_current = next;
+    return true;
+}
+
+void ReprojectionCache::Store(const Params& params, Precision precision)
+{
+    m_cachedParams = params;
+    m_cachedPrecision = precision;
+    m_valid = true;
+}
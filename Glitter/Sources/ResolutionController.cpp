@@ -0,0 +1,74 @@
+#include "ResolutionController.hpp"
+
+#include <iostream>
+
+ResolutionController::ResolutionController()
+    :
+    m_width(0),
+    m_height(0),
+    m_step(1),
+    m_costPerSample(0.0),
+    m_kernelTime(0.0f),
+    m_eventStep(1),
+    m_pending(false)
+{
+}
+
+void ResolutionController::Init(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+}
+
+void ResolutionController::Submit(const cl::Event& event, int step)
+{
+    // One measurement in flight is enough, the next frame's is taken once it lands
+    if (m_pending)
+        return;
+
+    m_event = event;
+    m_eventStep = step;
+    m_pending = true;
+}
+
+void ResolutionController::Update(float targetMs)
+{
+    if (m_pending && m_event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() == CL_COMPLETE)
+    {
+        cl_int err = CL_SUCCESS;
+        const cl_ulong start = m_event.getProfilingInfo<CL_PROFILING_COMMAND_START>(&err);
+        const cl_ulong end = m_event.getProfilingInfo<CL_PROFILING_COMMAND_END>(&err);
+        if (err == CL_SUCCESS && end > start)
+        {
+            m_kernelTime = (float)((end - start) * 1e-6);
+            const double cost = m_kernelTime / GetSamples(m_eventStep);
+
+            // Views change the cost by orders of magnitude, so the average follows quickly
+            m_costPerSample = m_costPerSample > 0.0 ? 0.5 * (m_costPerSample + cost) : cost;
+        }
+        else if (err != CL_SUCCESS)
+            std::cout << "Error reading kernel profiling info" << " " << err << "\n";
+
+        m_pending = false;
+    }
+
+    if (m_costPerSample <= 0.0)
+        return;
+
+    // Finest step predicted to fit. Going finer than the current step needs more headroom
+    // than staying, so a view near the budget does not flip between two steps every frame.
+    for (int step = 1; step <= maxStep; step++)
+    {
+        const double budget = targetMs * (step < m_step ? 0.7 : 0.9);
+        if (m_costPerSample * GetSamples(step) <= budget || step == maxStep)
+        {
+            m_step = step;
+            break;
+        }
+    }
+}
+
+double ResolutionController::GetSamples(int step) const
+{
+    return (double)((m_width + step - 1) / step) * ((m_height + step - 1) / step);
+}
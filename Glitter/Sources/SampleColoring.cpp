@@ -0,0 +1,91 @@
+#include "SampleColoring.hpp"
+
+#include <iostream>
+
+SampleColoring::SampleColoring()
+    :
+    m_period(1.0f),
+    m_width(0),
+    m_height(0)
+{
+}
+
+bool SampleColoring::Init(const cl::Context& context, const cl::Program& program, int width, int height)
+{
+    m_context = context;
+    Resize(width, height);
+
+    cl_int err = CL_SUCCESS;
+    m_noDistance = cl::Buffer(context, CL_MEM_READ_ONLY, sizeof(cl_float), NULL, &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating coloring buffers" << " " << err << "\n";
+        return false;
+    }
+
+    return SetProgram(program) && SetPalette(Palette());
+}
+
+bool SampleColoring::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_kernel = cl::Kernel(program, "ColorSamples", &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating ColorSamples kernel" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+void SampleColoring::Resize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+}
+
+bool SampleColoring::SetPalette(const Palette& palette)
+{
+    // Float texels keep the LUT smooth under exposure
+    std::vector<cl_float4> lut = palette.Bake();
+    cl_int err = CL_SUCCESS;
+    m_palette = cl::Image1D(m_context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, cl::ImageFormat(CL_RGBA, CL_FLOAT),
+        lut.size(), &lut[0], &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error uploading palette " << palette.GetName() << " " << err << "\n";
+        return false;
+    }
+
+    m_period = palette.GetPeriod();
+    return true;
+}
+
+bool SampleColoring::Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer& samples, int step, const Params& params,
+    int rowBegin, int rowEnd, const cl::Buffer* distance)
+{
+    if (rowEnd < 0)
+        rowEnd = m_height;
+
+    m_kernel.setArg(0, image);
+    m_kernel.setArg(1, samples);
+    m_kernel.setArg(2, (cl_int)step);
+    // Offset and density are in iterations, the LUT coordinate in palette cycles
+    m_kernel.setArg(3, m_palette);
+    m_kernel.setArg(4, params.paletteDensity / m_period);
+    m_kernel.setArg(5, params.paletteOffset / m_period);
+    m_kernel.setArg(6, params.exposure);
+    const bool shade = distance != NULL && params.distanceEstimate;
+    m_kernel.setArg(7, shade ? *distance : m_noDistance);
+    m_kernel.setArg(8, shade ? params.boundaryWidth : 0.0f);
+    cl_int2 size;
+    size.s[0] = m_width;
+    size.s[1] = m_height;
+    m_kernel.setArg(9, size);
+
+    const cl_int err = queue.enqueueNDRangeKernel(m_kernel, cl::NDRange(0, rowBegin), cl::NDRange(m_width, rowEnd - rowBegin));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing ColorSamples" << " " << err << "\n";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,447 @@
+#include "Sequence.hpp"
+#include "Headless.hpp"
+#include "CpuRenderer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <stb_image_write.h>
+
+// The output path becomes a printf format, so it may hold exactly one int conversion
+// (flags, width and precision allowed) and otherwise only %% escapes
+static bool IsFramePattern(const std::string& output)
+{
+    int conversions = 0;
+    for (size_t i = 0; i < output.length(); i++)
+    {
+        if (output[i] != '%')
+            continue;
+        if (++i < output.length() && output[i] == '%')
+            continue;
+
+        while (i < output.length() && std::string("-+ #0").find(output[i]) != std::string::npos)
+            i++;
+        while (i < output.length() && isdigit((unsigned char)output[i]))
+            i++;
+        if (i < output.length() && output[i] == '.')
+            for (i++; i < output.length() && isdigit((unsigned char)output[i]); i++);
+        if (i >= output.length() || (output[i] != 'd' && output[i] != 'i'))
+            return false;
+        conversions++;
+    }
+
+    return conversions == 1;
+}
+
+bool ZoomPath::Load(const std::string& path)
+{
+    std::ifstream file(path.c_str());
+    if (!file) {
+        std::cout << "Error opening keyframes " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        std::istringstream stream(line);
+        std::string first;
+        if (!(stream >> first) || first[0] == '#')
+            continue;
+
+        // strtod keeps every digit of the center a double can hold
+        Keyframe keyframe;
+        std::string dx, dy;
+        keyframe.time = atof(first.c_str());
+        if (!(stream >> dx >> dy >> keyframe.scale) || keyframe.scale <= 0.0) {
+            std::cout << "Error in keyframes " << path << " line " << lineNumber << "\n";
+            return false;
+        }
+        keyframe.dx = strtod(dx.c_str(), NULL);
+        keyframe.dy = strtod(dy.c_str(), NULL);
+
+        if (!Add(keyframe)) {
+            std::cout << "Error in keyframes " << path << " line " << lineNumber << ": times must increase\n";
+            return false;
+        }
+    }
+
+    if (m_keyframes.empty()) {
+        std::cout << "Error keyframes " << path << " has no keyframes\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool ZoomPath::Add(const Keyframe& keyframe)
+{
+    if (!m_keyframes.empty() && keyframe.time <= m_keyframes.back().time)
+        return false;
+
+    m_keyframes.push_back(keyframe);
+    return true;
+}
+
+Params ZoomPath::Evaluate(double time, const Params& base) const
+{
+    Params params = base;
+    if (m_keyframes.empty())
+        return params;
+
+    size_t next = 0;
+    while (next < m_keyframes.size() && m_keyframes[next].time < time)
+        next++;
+
+    if (next == 0 || next == m_keyframes.size())
+    {
+        const Keyframe& key = next == 0 ? m_keyframes.front() : m_keyframes.back();
+        params.dx = key.dx;
+        params.dy = key.dy;
+        params.scale = key.scale;
+        return params;
+    }
+
+    const Keyframe& a = m_keyframes[next - 1];
+    const Keyframe& b = m_keyframes[next];
+    const double u = (time - a.time) / (b.time - a.time);
+
+    // Exponential zoom: the log of the scale moves linearly
+    params.scale = a.scale * std::pow(b.scale / a.scale, u);
+
+    // The screen position of b's center moves linearly when the center covers the fraction
+    // (1 - a.scale / scale) / (1 - a.scale / b.scale) of the way
+    double w = u;
+    const double ratio = a.scale / b.scale;
+    if (std::fabs(1.0 - ratio) > 1e-9)
+        w = (1.0 - a.scale / params.scale) / (1.0 - ratio);
+    params.dx = a.dx + (b.dx - a.dx) * w;
+    params.dy = a.dy + (b.dy - a.dy) * w;
+
+    return params;
+}
+
+FrameWriter::FrameWriter(int width, int height)
+    :
+    m_width(width),
+    m_height(height),
+    m_y4m(false),
+    m_stream(NULL),
+    m_closing(false),
+    m_failed(false),
+    m_stallTime(0.0)
+{
+}
+
+FrameWriter::~FrameWriter()
+{
+    Close();
+}
+
+bool FrameWriter::Open(const std::string& output, int fps, int writerCount)
+{
+    m_output = output;
+    m_y4m = output.size() >= 4 && output.compare(output.size() - 4, 4, ".y4m") == 0;
+
+    if (m_y4m)
+    {
+        m_stream = fopen(output.c_str(), "wb");
+        if (m_stream == NULL) {
+            std::cout << "Error opening " << output << "\n";
+            return false;
+        }
+
+        // C420jpeg: full range BT.601 with centered chroma, what the conversion below produces
+        fprintf(m_stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", m_width, m_height, fps);
+        m_planes.resize((size_t)m_width * m_height + 2 * (size_t)((m_width + 1) / 2) * ((m_height + 1) / 2));
+        writerCount = 1;
+    }
+    else
+    {
+        if (!IsFramePattern(output)) {
+            std::cout << "Error PNG sequence output needs one frame number pattern, e.g. frame_%05d.png\n";
+            return false;
+        }
+        if (writerCount <= 0)
+            writerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    // One buffer per writer plus two, one being filled and one queued
+    for (int i = 0; i < writerCount + 2; i++)
+    {
+        m_buffers.push_back(std::unique_ptr<std::vector<unsigned char>>(new std::vector<unsigned char>((size_t)m_width * m_height * 4)));
+        m_free.push_back(m_buffers.back().get());
+    }
+
+    for (int i = 0; i < writerCount; i++)
+        m_writers.push_back(std::thread(&FrameWriter::WriterLoop, this));
+
+    std::cout << "Writing " << (m_y4m ? "Y4M stream " : "PNG frames ") << output << " with " << writerCount << " writer threads\n";
+    return true;
+}
+
+std::vector<unsigned char>* FrameWriter::Acquire()
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_bufferFree.wait(lock, [this] { return !m_free.empty(); });
+    std::vector<unsigned char>* pixels = m_free.back();
+    m_free.pop_back();
+
+    m_stallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return pixels;
+}
+
+void FrameWriter::Submit(int frame, std::vector<unsigned char>* pixels)
+{
+    Job job;
+    job.frame = frame;
+    job.pixels = pixels;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+    }
+    m_jobReady.notify_one();
+}
+
+bool FrameWriter::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_jobReady.notify_all();
+
+    for (std::thread& writer : m_writers)
+        writer.join();
+    m_writers.clear();
+
+    if (m_stream != NULL)
+    {
+        if (fclose(m_stream) != 0)
+            m_failed = true;
+        m_stream = NULL;
+    }
+
+    return !m_failed;
+}
+
+void FrameWriter::WriterLoop()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobReady.wait(lock, [this] { return m_closing || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                return;
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        const bool written = m_y4m ? WriteY4mFrame(job) : WritePngFrame(job);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!written)
+                m_failed = true;
+            m_free.push_back(job.pixels);
+        }
+        m_bufferFree.notify_one();
+    }
+}
+
+bool FrameWriter::WritePngFrame(const Job& job) const
+{
+    char path[1024];
+    snprintf(path, sizeof(path), m_output.c_str(), job.frame);
+    if (!stbi_write_png(path, m_width, m_height, 4, &(*job.pixels)[0], m_width * 4))
+    {
+        std::cout << "Error writing " + std::string(path) + "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool FrameWriter::WriteY4mFrame(const Job& job)
+{
+    const std::vector<unsigned char>& rgba = *job.pixels;
+    const int chromaWidth = (m_width + 1) / 2;
+    const int chromaHeight = (m_height + 1) / 2;
+    unsigned char* yPlane = &m_planes[0];
+    unsigned char* uPlane = yPlane + (size_t)m_width * m_height;
+    unsigned char* vPlane = uPlane + (size_t)chromaWidth * chromaHeight;
+
+    // Full range BT.601 in 8.8 fixed point; the +32768 keeps the chroma sums positive
+    for (size_t p = 0; p < (size_t)m_width * m_height; p++)
+    {
+        const int r = rgba[4 * p];
+        const int g = rgba[4 * p + 1];
+        const int b = rgba[4 * p + 2];
+        yPlane[p] = (unsigned char)((77 * r + 150 * g + 29 * b + 128) >> 8);
+    }
+
+    // Chroma of the average color of each 2x2 block, edge pixels repeated for odd sizes
+    for (int cy = 0; cy < chromaHeight; cy++)
+    {
+        for (int cx = 0; cx < chromaWidth; cx++)
+        {
+            int sum[3] = { 0, 0, 0 };
+            for (int j = 0; j < 4; j++)
+            {
+                const int x = std::min(2 * cx + j % 2, m_width - 1);
+                const int y = std::min(2 * cy + j / 2, m_height - 1);
+                const unsigned char* pixel = &rgba[4 * ((size_t)y * m_width + x)];
+                for (int c = 0; c < 3; c++)
+                    sum[c] += pixel[c];
+            }
+
+            const int r = (sum[0] + 2) / 4;
+            const int g = (sum[1] + 2) / 4;
+            const int b = (sum[2] + 2) / 4;
+            uPlane[(size_t)cy * chromaWidth + cx] = (unsigned char)((-43 * r - 85 * g + 128 * b + 32768 + 128) >> 8);
+            vPlane[(size_t)cy * chromaWidth + cx] = (unsigned char)((128 * r - 107 * g - 21 * b + 32768 + 128) >> 8);
+        }
+    }
+
+    if (fputs("FRAME\n", m_stream) < 0 || fwrite(&m_planes[0], 1, m_planes.size(), m_stream) != m_planes.size())
+    {
+        std::cout << "Error writing frame " << job.frame << " to " << m_output << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool RunSequence(const Options& options, const Palette& palette)
+{
+    // The exponential map resamples a zoom into one fixed target
+    bool expMap = options.expMap;
+    if (expMap && !options.keyframes.empty()) {
+        std::cout << "Error the exponential map only renders straight zooms, not keyframed paths\n";
+        return false;
+    }
+
+    ZoomPath path;
+    if (!options.keyframes.empty())
+    {
+        if (!path.Load(options.keyframes))
+            return false;
+    }
+    else
+    {
+        // Straight zoom into the start view's center
+        Keyframe start;
+        start.dx = options.params.dx;
+        start.dy = options.params.dy;
+        start.scale = options.params.scale;
+        Keyframe end = start;
+        end.time = options.duration;
+        end.scale = options.zoomEnd > 0.0 ? options.zoomEnd : start.scale * 1000.0;
+        path.Add(start);
+        if (!path.Add(end)) {
+            std::cout << "Error sequence duration must be positive\n";
+            return false;
+        }
+        if (expMap && end.scale < start.scale) {
+            std::cout << "Error the exponential map only renders zooms in\n";
+            return false;
+        }
+    }
+
+    const double duration = path.GetDuration();
+    const int frameCount = options.frames > 0 ? options.frames : (int)std::floor(duration * options.fps + 1e-9) + 1;
+
+    // The path moves the center every frame, so perturbation references follow it
+    Params base = options.params;
+    base.deepZoom = false;
+
+    std::unique_ptr<HeadlessRenderer> gpu;
+    std::unique_ptr<CpuRenderer> cpu;
+    if (!options.cpu)
+    {
+        gpu.reset(new HeadlessRenderer(options.width, options.height));
+        if (!gpu->Init(base, options.device) || !gpu->SetPalette(palette))
+        {
+            std::cout << "No usable OpenCL device, falling back to the CPU renderer\n";
+            gpu.reset();
+        }
+    }
+    if (!gpu)
+    {
+        cpu.reset(new CpuRenderer(options.width, options.height));
+        if (!cpu->Init(options.isa, options.threads, options.tileSize))
+            return false;
+        cpu->SetPalette(palette);
+        cpu->SetVerbose(false);
+    }
+    else
+        gpu->SetVerbose(false);
+
+    if (expMap && !gpu)
+    {
+        std::cout << "The exponential map needs OpenCL, rendering every frame\n";
+        expMap = false;
+    }
+    if (expMap && !gpu->BeginExpMap(path.Evaluate(0.0, base)))
+        return false;
+
+    FrameWriter writer(options.width, options.height);
+    if (!writer.Open(options.sequence, options.fps, options.writers))
+        return false;
+
+    std::cout << "Rendering " << frameCount << " frames of " << options.width << "x" << options.height << " over "
+        << duration << " s of zoom path\n";
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double renderTime = 0.0;
+    bool rendered = true;
+    for (int frame = 0; frame < frameCount && rendered; frame++)
+    {
+        // A given frame count spreads the frames over the whole path, otherwise they are 1/fps apart
+        double time = std::min(frame / (double)options.fps, duration);
+        if (options.frames > 0)
+            time = frameCount > 1 ? duration * frame / (frameCount - 1) : 0.0;
+        const Params params = path.Evaluate(time, base);
+
+        // Rendering overlaps with the writers still encoding earlier frames
+        const std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+        if (expMap)
+            rendered = gpu->RenderExpMap(params);
+        else
+            rendered = gpu ? gpu->Render(params) : cpu->Render(params);
+        renderTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+        if (!rendered)
+            break;
+
+        std::vector<unsigned char>* pixels = writer.Acquire();
+        const std::vector<unsigned char>& source = gpu ? gpu->GetPixels() : cpu->GetPixels();
+        std::copy(source.begin(), source.end(), pixels->begin());
+        writer.Submit(frame, pixels);
+
+        if ((frame + 1) % std::max(options.fps, 1) == 0 || frame + 1 == frameCount)
+            std::cout << "Frame " << frame + 1 << "/" << frameCount << ", scale " << params.scale << "\n";
+    }
+
+    const bool written = writer.Close();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Sequence: " << frameCount << " frames in " << seconds << " s, " << frameCount / seconds << " fps ("
+        << renderTime * 1000.0 / frameCount << " ms rendering per frame, " << writer.GetStallTime() << " s waiting for writers)\n";
+    if (expMap)
+    {
+        const double framePixels = (double)options.width * options.height * frameCount;
+        std::cout << "Exponential map iterated " << gpu->GetExpMap().GetIteratedSamples() << " samples, "
+            << gpu->GetExpMap().GetIteratedSamples() * 100.0 / framePixels << "% of iterating every frame\n";
+    }
+
+    return rendered && written;
+}
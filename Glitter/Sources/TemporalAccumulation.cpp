@@ -0,0 +1,129 @@
+#include "TemporalAccumulation.hpp"
+
+#include <cmath>
+#include <iostream>
+
+TemporalAccumulation::TemporalAccumulation()
+    :
+    m_width(0),
+    m_height(0),
+    m_capacity(0),
+    m_frames(1)
+{
+}
+
+bool TemporalAccumulation::Init(const cl::Context& context, const cl::Program& program, int width, int height, const cl::Buffer& earlyExits)
+{
+    m_context = context;
+    m_earlyExits = earlyExits;
+
+    return Resize(width, height) && SetProgram(program);
+}
+
+bool TemporalAccumulation::Resize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    Reset();
+
+    const size_t pixels = (size_t)width * height;
+    if (pixels <= m_capacity)
+        return true;
+
+    cl_int err = CL_SUCCESS;
+    m_accum = cl::Buffer(m_context, CL_MEM_READ_WRITE, sizeof(cl_float4) * pixels, NULL, &err);
+    if (err != CL_SUCCESS) {
+        m_capacity = 0;
+        std::cout << "Error creating accumulation buffer" << " " << err << "\n";
+        return false;
+    }
+    m_capacity = pixels;
+
+    if (m_kernel() != NULL)
+    {
+        m_seedKernel.setArg(6, m_accum);
+        m_kernel.setArg(13, m_accum);
+    }
+
+    return true;
+}
+
+bool TemporalAccumulation::SetProgram(const cl::Program& program)
+{
+    cl_int err = CL_SUCCESS;
+    m_seedKernel = cl::Kernel(program, "AccumulateSeed", &err);
+    if (err == CL_SUCCESS)
+        m_kernel = cl::Kernel(program, "AccumulateJittered", &err);
+    if (err != CL_SUCCESS) {
+        std::cout << "Error creating accumulation kernels" << " " << err << "\n";
+        return false;
+    }
+
+    m_seedKernel.setArg(6, m_accum);
+    m_kernel.setArg(6, m_earlyExits);
+    m_kernel.setArg(13, m_accum);
+
+    return true;
+}
+
+bool TemporalAccumulation::Seed(const cl::CommandQueue& queue, const cl::Buffer& samples, const SampleColoring& coloring,
+    const Params& params)
+{
+    cl_int2 size;
+    size.s[0] = m_width;
+    size.s[1] = m_height;
+
+    m_seedKernel.setArg(0, size);
+    m_seedKernel.setArg(1, samples);
+    m_seedKernel.setArg(2, coloring.GetPalette());
+    m_seedKernel.setArg(3, params.paletteDensity / coloring.GetPeriod());
+    m_seedKernel.setArg(4, params.paletteOffset / coloring.GetPeriod());
+    m_seedKernel.setArg(5, params.exposure);
+    const cl_int err = queue.enqueueNDRangeKernel(m_seedKernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing AccumulateSeed" << " " << err << "\n";
+        return false;
+    }
+
+    Reset();
+    return true;
+}
+
+bool TemporalAccumulation::Render(const cl::CommandQueue& queue, const cl::Image2D& image, const cl::Buffer* distance,
+    const SampleColoring& coloring, const Params& params)
+{
+    // R2 sequence (plastic number), offset so frame 0 is the pixel center: any run of
+    // consecutive frames covers the pixel evenly, so the mean converges at every frame count
+    const double a1 = 0.7548776662466927;
+    const double a2 = 0.5698402909980532;
+    cl_float2 jitter;
+    jitter.s[0] = (cl_float)(std::fmod(0.5 + a1 * m_frames, 1.0) - 0.5);
+    jitter.s[1] = (cl_float)(std::fmod(0.5 + a2 * m_frames, 1.0) - 0.5);
+
+    cl_int2 size;
+    size.s[0] = m_width;
+    size.s[1] = m_height;
+
+    const bool shade = distance != NULL && params.distanceEstimate;
+    m_kernel.setArg(0, size);
+    m_kernel.setArg(1, (cl_float)params.dx);
+    m_kernel.setArg(2, (cl_float)params.dy);
+    m_kernel.setArg(3, (cl_float)params.scale);
+    m_kernel.setArg(4, jitter);
+    m_kernel.setArg(5, params.GetPeriodCheck());
+    m_kernel.setArg(7, coloring.GetPalette());
+    m_kernel.setArg(8, params.paletteDensity / coloring.GetPeriod());
+    m_kernel.setArg(9, params.paletteOffset / coloring.GetPeriod());
+    m_kernel.setArg(10, params.exposure);
+    m_kernel.setArg(11, shade ? *distance : coloring.GetNoDistance());
+    m_kernel.setArg(12, shade ? params.boundaryWidth : 0.0f);
+    m_kernel.setArg(14, image);
+    const cl_int err = queue.enqueueNDRangeKernel(m_kernel, cl::NullRange, cl::NDRange(m_width, m_height));
+    if (err != CL_SUCCESS) {
+        std::cout << "Error enqueueing AccumulateJittered" << " " << err << "\n";
+        return false;
+    }
+
+    m_frames++;
+    return true;
+}
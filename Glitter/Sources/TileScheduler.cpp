@@ -0,0 +1,136 @@
+#include "TileScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+TileScheduler::TileScheduler(int threadCount)
+    :
+    m_threadCount(threadCount),
+    m_generation(0),
+    m_busy(0),
+    m_quit(false),
+    m_task(NULL),
+    m_costs(NULL),
+    m_steals(0)
+{
+    if (m_threadCount <= 0)
+        m_threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+    m_queues.reset(new WorkerQueue[m_threadCount]);
+    for (int worker = 1; worker < m_threadCount; worker++)
+        m_threads.push_back(std::thread(&TileScheduler::WorkerLoop, this, worker));
+}
+
+TileScheduler::~TileScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_start.notify_all();
+
+    for (std::thread& thread : m_threads)
+        thread.join();
+}
+
+void TileScheduler::Run(int tileCount, const std::function<void(int, int)>& task, std::vector<double>* costs)
+{
+    std::vector<int> order(tileCount);
+    for (int tile = 0; tile < tileCount; tile++)
+        order[tile] = tile;
+
+    // Longest first: expensive tiles start early and cheap ones fill the gaps at the end
+    if (costs != NULL && (int)costs->size() == tileCount)
+    {
+        const std::vector<double>& previous = *costs;
+        std::stable_sort(order.begin(), order.end(), [&previous](int a, int b) { return previous[a] > previous[b]; });
+    }
+    else if (costs != NULL)
+        costs->assign(tileCount, 0.0);
+
+    for (int i = 0; i < tileCount; i++)
+        m_queues[i % m_threadCount].tiles.push_back(order[i]);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_costs = costs;
+        m_steals = 0;
+        m_busy = m_threadCount - 1;
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    Work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = NULL;
+    m_costs = NULL;
+}
+
+void TileScheduler::WorkerLoop(int worker)
+{
+    unsigned int generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, generation] { return m_quit || m_generation != generation; });
+            if (m_quit)
+                return;
+            generation = m_generation;
+        }
+
+        Work(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_busy--;
+        }
+        m_done.notify_one();
+    }
+}
+
+void TileScheduler::Work(int worker)
+{
+    int tile = 0;
+    while (Pop(worker, tile) || Steal(worker, tile))
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        (*m_task)(tile, worker);
+        if (m_costs != NULL)
+            (*m_costs)[tile] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+bool TileScheduler::Pop(int worker, int& tile)
+{
+    WorkerQueue& queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tiles.empty())
+        return false;
+
+    tile = queue.tiles.front();
+    queue.tiles.pop_front();
+    return true;
+}
+
+bool TileScheduler::Steal(int worker, int& tile)
+{
+    // Tiles are never added during a run, so one empty sweep means the frame is done
+    for (int i = 1; i < m_threadCount; i++)
+    {
+        WorkerQueue& victim = m_queues[(worker + i) % m_threadCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tiles.empty())
+            continue;
+
+        tile = victim.tiles.back();
+        victim.tiles.pop_back();
+        m_steals++;
+        return true;
+    }
+
+    return false;
+}
@@ -1,7 +1,15 @@
 ﻿const float2 xMinMax = (float2)(-2.0f, 0.47f);
 const float2 yMinMax = (float2)(-1.12f, 1.12f);
 const float scale = 1.0f;
-const int maxIter = 1000;
+
+// Iteration limit and squared escape radius, set per program build by ProgramCache
+#ifndef MAX_ITER
+#define MAX_ITER 1000
+#endif
+#ifndef BAILOUT
+#define BAILOUT 65536.0f
+#endif
+const int maxIter = MAX_ITER;
 
 float4 lerp(float4 a, float4 b, float t)
 {
@@ -21,31 +29,74 @@ kernel void test(__global int* test_buf)
 	test_buf[x] = x;
 }
 
-// Colors
-const float pos[] = { 0.0f, 0.16f, 0.42f, 0.6425f, 0.8575f };
-const float3 col[] = { (float3)(0, 7, 100),
-				(float3)(32, 107, 203),
-				(float3)(237, 255, 255),
-				(float3)(255, 170, 0),
-				(float3)(0, 2, 0)};
-
-const float3 cols[] = { (float3)(66, 30, 15),
-	(float3)(25, 7, 26),
-	(float3)(9, 1, 47),
-	(float3)(4, 4, 73),
-	(float3)(0, 7, 100),
-	(float3)(12, 44, 138),
-	(float3)(24, 82, 177),
-	(float3)(57, 125, 209),
-	(float3)(134, 181, 229),
-	(float3)(211, 236, 248),
-	(float3)(241, 233, 191),
-	(float3)(248, 201, 95),
-	(float3)(255, 170, 0),
-	(float3)(204, 128, 0),
-	(float3)(153, 87, 0),
-	(float3)(106, 52, 3)
-};
+// Palettes are baked on the host into a 1D LUT image (see Palette) and read with hardware
+// linear filtering. The smooth palette repeats, the histogram palette is spread once over
+// the escaped pixels.
+__constant sampler_t paletteSampler = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_REPEAT | CLK_FILTER_LINEAR;
+__constant sampler_t histogramSampler = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_LINEAR;
+
+// Interior early-outs. periodCheck < 0 disables them, 0 keeps only the analytic main cardioid
+// and period-2 bulb test, > 0 also runs Brent periodicity detection starting with a window of
+// periodCheck iterations. earlyExits[0] counts pixels caught by the analytic test and
+// earlyExits[1] those caught by periodicity.
+bool InCardioidOrBulb(float x0, float y0)
+{
+	const float xq = x0 - 0.25f;
+	const float q = xq * xq + y0 * y0;
+	if (q * (q + xq) <= 0.25f * y0 * y0)
+		return true;
+
+	const float xb = x0 + 1.0f;
+	return xb * xb + y0 * y0 <= 0.0625f;
+}
+
+// Escape-time loop in float, returns the iteration count and the final z
+int IterateFloat(float x0, float y0, float bailout, int periodCheck, global int* earlyExits, float2* z)
+{
+	*z = (float2)(0.0f, 0.0f);
+	if (periodCheck >= 0 && InCardioidOrBulb(x0, y0))
+	{
+		atomic_inc(&earlyExits[0]);
+		return maxIter;
+	}
+
+	float xi = 0.0f;
+	float yi = 0.0f;
+	float savedX = 0.0f;
+	float savedY = 0.0f;
+	int window = periodCheck;
+	int windowEnd = periodCheck;
+	int iter = 0;
+	while (xi * xi + yi * yi <= bailout && iter < maxIter)
+	{
+		float xTemp = xi * xi - yi * yi + x0;
+		yi = 2 * xi * yi + y0;
+		xi = xTemp;
+		iter++;
+
+		// Brent: an exact repeat of the saved z means the (float) orbit cycles and never escapes,
+		// so the result is identical to running the loop out
+		if (periodCheck > 0)
+		{
+			if (xi == savedX && yi == savedY)
+			{
+				atomic_inc(&earlyExits[1]);
+				iter = maxIter;
+				break;
+			}
+			if (iter == windowEnd)
+			{
+				savedX = xi;
+				savedY = yi;
+				window *= 2;
+				windowEnd += window;
+			}
+		}
+	}
+
+	*z = (float2)(xi, yi);
+	return iter;
+}
 
 //x0: = scaled x coordinate of pixel(scaled to lie in the Mandelbrot X scale(-2.00, 0.47))
 //y0 : = scaled y coordinate of pixel(scaled to lie in the Mandelbrot Y scale(-1.12, 1.12))
@@ -61,7 +112,7 @@ const float3 cols[] = { (float3)(66, 30, 15),
 //
 //    color : = palette[iteration]
 //    plot(Px, Py, color)
-kernel void Mandel(write_only image2d_t res, float dx, float dy, float scale)
+kernel void Mandel(write_only image2d_t res, float dx, float dy, float scale, int periodCheck, global int* earlyExits)
 {
 	// x0{ ((xMax - xMin) * va[i].position.x / width + xMin) / scale + dx };
 	// y0{ ((yMax - yMin) * (height - va[i].position.y) / height + yMin) / scale + dy };
@@ -74,16 +125,8 @@ kernel void Mandel(write_only image2d_t res, float dx, float dy, float scale)
 	const float x0 = ((xMinMax.y - xMinMax.x) * x / width + xMinMax.x) / scale + dx;
 	const float y0 = ((yMinMax.y - yMinMax.x) * (height - y) / height + yMinMax.x) / scale + dy;
 
-	float xi = 0.0f;
-	float yi = 0.0f;
-	int iter = 0;
-	while (xi * xi + yi * yi <= 4 && iter < maxIter)
-	{
-		float xTemp = xi * xi - yi * yi + x0;
-		yi = 2 * xi * yi + y0;
-		xi = xTemp;
-		iter++;
-	}
+	float2 z;
+	const int iter = IterateFloat(x0, y0, 4, periodCheck, earlyExits, &z);
 
 	const float4 col = (float4)(iter / 256 * 5 + 127,
 		iter % 256,
@@ -94,133 +137,1065 @@ kernel void Mandel(write_only image2d_t res, float dx, float dy, float scale)
 	write_imagef(res, (int2)(x, y), convCol);
 }
 
-kernel void CalculateIterCounts(read_only image2d_t res, float dx, float dy, float scale, global int* iterCounts)
+// Normalized (fractional) iteration count of an orbit ending at |z|^2 = zz
+float SmoothIteration(int iter, float zz)
 {
-	// x0{ ((xMax - xMin) * va[i].position.x / width + xMin) / scale + dx };
-	// y0{ ((yMax - yMin) * (height - va[i].position.y) / height + yMin) / scale + dy };
+	float flIter = iter;
+	// Used to avoid floating point issues with points inside the set.
+	if (iter < maxIter)
+	{
+		// sqrt of inner term removed using log simplification rules.
+		float log_zn = log(zz) / 2;
+		float nu = log(log_zn / log(2.0f)) / log(2.0f);
+		// Rearranging the potential function.
+		// Dividing log_zn by log(2) instead of log(N = 1<<8)
+		// because we want the entire palette to range from the
+		// center to radius 2, NOT our bailout radius.
+		flIter = iter + 1 - nu;
+	}
 
+	return flIter;
+}
+
+// Palette color of a sample: the smooth iteration count, scaled by paletteScale and moved by
+// paletteOffset (both in palette cycles), is the LUT coordinate. Interior and immediately
+// escaping pixels are black.
+float4 PaletteColor(int iter, float zz, read_only image1d_t palette, float paletteScale, float paletteOffset, float exposure)
+{
+	if (iter >= maxIter || iter <= 0)
+		return (float4)(0.0f, 0.0f, 0.0f, 1.0f);
+
+	const float4 col = read_imagef(palette, paletteSampler, SmoothIteration(iter, zz) * paletteScale + paletteOffset);
+
+	return (float4)(clamp(col.xyz * exposure, 0.0f, 1.0f), 1.0f);
+}
+
+// Per-pixel orbit results are kept in a compact sample buffer as (iter, |z|^2), a negative
+// iter marks a sample that still has to be computed. Iteration kernels only write samples;
+// ColorSamples turns them into pixels, so coloring changes never iterate again.
+//
+// Progressive refinement: work item (gx, gy) computes the sample at (gx, gy) * step, which
+// colors its step x step block. Valid samples on the previous, coarser grid (prevStep) are
+// reused instead of recomputed. A full frame is step 1, prevStep 0; step 1, prevStep 1 only
+// computes the samples a pan reprojection invalidated.
+bool ReuseSample(global const float2* samples, int x, int y, int width, int prevStep)
+{
+	return prevStep > 0 && x % prevStep == 0 && y % prevStep == 0 && samples[x + y * width].x >= 0.0f;
+}
+
+// Pan reprojection: moves cached samples by a whole pixel shift, exposed pixels become invalid
+kernel void Reproject(global const float2* oldSamples, global float2* newSamples, int width, int height, int shiftX, int shiftY)
+{
 	const int x = get_global_id(0);
 	const int y = get_global_id(1);
-	const int width = get_image_width(res);
-	const int height = get_image_height(res);
+	const int sx = x + shiftX;
+	const int sy = y + shiftY;
+
+	newSamples[x + y * width] = (sx >= 0 && sx < width && sy >= 0 && sy < height) ?
+		oldSamples[sx + sy * width] : (float2)(-1.0f, 0.0f);
+}
+
+// Moves the distance estimates along with the samples, exposed pixels become unknown
+kernel void ReprojectDistance(global const float* oldDistance, global float* newDistance, int width, int height, int shiftX, int shiftY)
+{
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	const int sx = x + shiftX;
+	const int sy = y + shiftY;
+
+	newDistance[x + y * width] = (sx >= 0 && sx < width && sy >= 0 && sy < height) ?
+		oldDistance[sx + sy * width] : -1.0f;
+}
 
+// Escape-time iteration of one pixel in float, returns the sample (iter, |z|^2)
+float2 IterateSmooth(int x, int y, int width, int height, float dx, float dy, float scale, int periodCheck, global int* earlyExits)
+{
 	const float x0 = ((xMinMax.y - xMinMax.x) * x / width + xMinMax.x) / scale + dx;
 	const float y0 = ((yMinMax.y - yMinMax.x) * (height - y) / height + yMinMax.x) / scale + dy;
 
+	float2 z;
+	const int iter = IterateFloat(x0, y0, BAILOUT, periodCheck, earlyExits, &z);
+
+	return (float2)(iter, z.x * z.x + z.y * z.y);
+}
+
+kernel void MandelSmooth(int2 size, float dx, float dy, float scale, global float2* samples, int step, int prevStep,
+	int periodCheck, global int* earlyExits)
+{
+	// x0{ ((xMax - xMin) * va[i].position.x / width + xMin) / scale + dx };
+	// y0{ ((yMax - yMin) * (height - va[i].position.y) / height + yMin) / scale + dy };
+
+	const int x = get_global_id(0) * step;
+	const int y = get_global_id(1) * step;
+	const int width = size.x;
+	const int height = size.y;
+	if (x >= width || y >= height || ReuseSample(samples, x, y, width, prevStep))
+		return;
+
+	samples[x + y * width] = IterateSmooth(x, y, width, height, dx, dy, scale, periodCheck, earlyExits);
+}
+
+// MandelSmooth that also carries the derivative dz/dc (dz' = 2 z dz + 1) and writes the
+// exterior distance estimate |z| log|z| / |dz| in pixels to distance, 0 inside the set. A
+// pixel closer than one pixel to the boundary holds part of a filament even when its own
+// orbit escapes, which the iteration count alone cannot tell.
+kernel void MandelSmoothDE(int2 size, float dx, float dy, float scale, global float2* samples, global float* distance,
+	int step, int prevStep, int periodCheck, global int* earlyExits)
+{
+	const int x = get_global_id(0) * step;
+	const int y = get_global_id(1) * step;
+	const int width = size.x;
+	const int height = size.y;
+	if (x >= width || y >= height || ReuseSample(samples, x, y, width, prevStep))
+		return;
+
+	const int index = x + y * width;
+	const float x0 = ((xMinMax.y - xMinMax.x) * x / width + xMinMax.x) / scale + dx;
+	const float y0 = ((yMinMax.y - yMinMax.x) * (height - y) / height + yMinMax.x) / scale + dy;
+	if (periodCheck >= 0 && InCardioidOrBulb(x0, y0))
+	{
+		atomic_inc(&earlyExits[0]);
+		samples[index] = (float2)(maxIter, 0.0f);
+		distance[index] = 0.0f;
+		return;
+	}
+
 	float xi = 0.0f;
 	float yi = 0.0f;
+	float dzx = 0.0f;
+	float dzy = 0.0f;
+	float savedX = 0.0f;
+	float savedY = 0.0f;
+	int window = periodCheck;
+	int windowEnd = periodCheck;
 	int iter = 0;
-	while (xi * xi + yi * yi <= (1 << 16) && iter < maxIter)
+	while (xi * xi + yi * yi <= BAILOUT && iter < maxIter)
 	{
+		const float dzxTemp = 2.0f * (xi * dzx - yi * dzy) + 1.0f;
+		dzy = 2.0f * (xi * dzy + yi * dzx);
+		dzx = dzxTemp;
+
 		float xTemp = xi * xi - yi * yi + x0;
 		yi = 2 * xi * yi + y0;
 		xi = xTemp;
 		iter++;
+
+		// Brent periodicity, see IterateFloat
+		if (periodCheck > 0)
+		{
+			if (xi == savedX && yi == savedY)
+			{
+				atomic_inc(&earlyExits[1]);
+				iter = maxIter;
+				break;
+			}
+			if (iter == windowEnd)
+			{
+				savedX = xi;
+				savedY = yi;
+				window *= 2;
+				windowEnd += window;
+			}
+		}
 	}
 
-	iterCounts[x + y * get_image_width(res)] = iter;
+	const float zz = xi * xi + yi * yi;
+	samples[index] = (float2)(iter, zz);
+
+	// An overflowing derivative gives 0, the pixel is on the boundary as far as float can tell
+	float estimate = 0.0f;
+	if (iter < maxIter)
+	{
+		const float r = sqrt(zz);
+		const float pixel = (xMinMax.y - xMinMax.x) / (width * scale);
+		estimate = r * log(r) / (length((float2)(dzx, dzy)) * pixel);
+	}
+	distance[index] = estimate;
+}
+
+// Boundary fade of a pixel color, see ColorSamples
+float4 BoundaryShade(float4 col, global const float* distance, int index, float boundaryWidth)
+{
+	if (boundaryWidth > 0.0f && distance[index] >= 0.0f)
+		col.xyz *= smoothstep(0.0f, boundaryWidth, distance[index]);
+
+	return col;
 }
 
-kernel void CalculateIterPerPixel(read_only image2d_t res, global int* iterCounts, global int* iterPerPixel)
+// Colors the sample buffer into the top-left size.x by size.y pixels of the image, which
+// may be larger (see FramePipeline). After a pass with step > 1 only every step-th
+// sample is valid; pixels between them blend the colors of the four surrounding samples
+// (bilinear upsampling), the last block of a row or column just takes its own. With
+// boundaryWidth > 0 escaped pixels closer than boundaryWidth pixels to the set
+// (MandelSmoothDE distance, negative when unknown) fade to black, so filaments thinner than
+// a pixel stay visible.
+kernel void ColorSamples(write_only image2d_t res, global const float2* samples, int step,
+	read_only image1d_t palette, float paletteScale, float paletteOffset, float exposure,
+	global const float* distance, float boundaryWidth, int2 size)
 {
 	const int x = get_global_id(0);
 	const int y = get_global_id(1);
-	const int width = get_image_width(res);
-	const int height = get_image_height(res);
+	const int width = size.x;
+	const int height = size.y;
+	const int x0 = x - x % step;
+	const int y0 = y - y % step;
+	const int x1 = x0 + step < width ? x0 + step : x0;
+	const int y1 = y0 + step < height ? y0 + step : y0;
+
+	float4 corners[4];
+	const int indices[4] = { x0 + y0 * width, x1 + y0 * width, x0 + y1 * width, x1 + y1 * width };
+	const int count = step > 1 ? 4 : 1;
+	for (int i = 0; i < count; i++)
+	{
+		const float2 sample = samples[indices[i]];
+		const float4 col = PaletteColor((int)sample.x, sample.y, palette, paletteScale, paletteOffset, exposure);
+		corners[i] = BoundaryShade(col, distance, indices[i], boundaryWidth);
+	}
+
+	float4 col = corners[0];
+	if (step > 1)
+	{
+		const float fx = (float)(x - x0) / step;
+		const float fy = (float)(y - y0) / step;
+		col = mix(mix(corners[0], corners[1], fx), mix(corners[2], corners[3], fx), fy);
+	}
+
+	write_imagef(res, (int2)(x, y), col);
+}
 
-	const int i = iterCounts[x + y * get_image_width(res)];
-	//NumIterationsPerPixel[i]++;
-	atomic_inc(&iterPerPixel[i]);
+// **********************************************************************************
+// Histogram coloring
+// Escaped iteration counts are binned (one bin per iteration up to HIST_BINS, proportionally
+// beyond), the bins are turned into a cumulative distribution and every pixel is colored by
+// the share of escaped pixels that escaped before it. Four passes, all on the device:
+// work-group histograms in local memory, a per-bin merge, a single work-group prefix sum
+// and the coloring itself.
+// **********************************************************************************
+
+#define HIST_BINS 4096
+
+int HistogramBins()
+{
+	return min(maxIter, HIST_BINS);
 }
 
-kernel void CalculateTotal(global int* iterPerPixel, global int* total)
+// Bins the work-group's strided share of the samples with local atomics and writes its
+// partial histogram to partials[group * bins + bin]. Interior pixels are not counted.
+kernel void HistogramLocal(global const float2* samples, int count, local int* bins, global int* partials)
 {
-	int tot = 0;
-	for (int i = 0; i < maxIter; i++)
-		tot += iterPerPixel[i];
+	const int lid = get_local_id(0);
+	const int groupSize = get_local_size(0);
+	const int binCount = HistogramBins();
 
-	total[0] = tot;
+	for (int b = lid; b < binCount; b += groupSize)
+		bins[b] = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int i = get_global_id(0); i < count; i += get_global_size(0))
+	{
+		const int iter = (int)samples[i].x;
+		if (iter < maxIter)
+			atomic_inc(&bins[(int)((long)iter * binCount / maxIter)]);
+	}
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	global int* partial = partials + get_group_id(0) * binCount;
+	for (int b = lid; b < binCount; b += groupSize)
+		partial[b] = bins[b];
 }
 
-kernel void MandelSmooth(write_only image2d_t res, float dx, float dy, float scale)
+// Sums the partial histograms, one work item per bin so the reads are coalesced
+kernel void HistogramMerge(global const int* partials, int groups, global int* histogram)
 {
-	// x0{ ((xMax - xMin) * va[i].position.x / width + xMin) / scale + dx };
-	// y0{ ((yMax - yMin) * (height - va[i].position.y) / height + yMin) / scale + dy };
+	const int b = get_global_id(0);
+	const int binCount = HistogramBins();
+	if (b >= binCount)
+		return;
+
+	int sum = 0;
+	for (int g = 0; g < groups; g++)
+		sum += partials[g * binCount + b];
+	histogram[b] = sum;
+}
+
+// Inclusive prefix sum of the histogram in a single work-group: every work item sums a
+// contiguous run of bins, the run totals are scanned in local memory (Hillis-Steele) and
+// each run is then written out from its exclusive prefix. cdf[bins - 1] is the escaped
+// pixel count.
+kernel void HistogramScan(global const int* histogram, local int* sums, global int* cdf)
+{
+	const int lid = get_local_id(0);
+	const int groupSize = get_local_size(0);
+	const int binCount = HistogramBins();
+	const int run = (binCount + groupSize - 1) / groupSize;
+	const int begin = min(lid * run, binCount);
+	const int end = min(begin + run, binCount);
+
+	int sum = 0;
+	for (int b = begin; b < end; b++)
+		sum += histogram[b];
+	sums[lid] = sum;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int offset = 1; offset < groupSize; offset *= 2)
+	{
+		const int value = lid >= offset ? sums[lid - offset] : 0;
+		barrier(CLK_LOCAL_MEM_FENCE);
+		sums[lid] += value;
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	int running = sums[lid] - sum;
+	for (int b = begin; b < end; b++)
+	{
+		running += histogram[b];
+		cdf[b] = running;
+	}
+}
 
+// Colors by the cumulative share of escaped pixels. The smooth iteration count interpolates
+// within a bin, so no bands show between neighboring counts.
+kernel void ColorHistogram(write_only image2d_t res, global const float2* samples, global const int* cdf,
+	read_only image1d_t palette, float exposure, int width)
+{
 	const int x = get_global_id(0);
 	const int y = get_global_id(1);
-	const int width = get_image_width(res);
-	const int height = get_image_height(res);
+	const float2 sample = samples[x + y * width];
+	const int iter = (int)sample.x;
+	if (iter >= maxIter)
+	{
+		write_imagef(res, (int2)(x, y), (float4)(0.0f, 0.0f, 0.0f, 1.0f));
+		return;
+	}
 
-	const float x0 = ((xMinMax.y - xMinMax.x) * x / width + xMinMax.x) / scale + dx;
-	const float y0 = ((yMinMax.y - yMinMax.x) * (height - y) / height + yMinMax.x) / scale + dy;
+	const int binCount = HistogramBins();
+	const float total = max(cdf[binCount - 1], 1);
+	const float position = clamp(SmoothIteration(iter, sample.y), 0.0f, (float)maxIter) * binCount / maxIter;
+	const int bin = clamp((int)position, 0, binCount - 1);
+	const float below = bin > 0 ? cdf[bin - 1] : 0.0f;
+	const float share = clamp((below + (cdf[bin] - below) * (position - bin)) / total, 0.0f, 1.0f);
 
-	float xi = 0.0f;
-	float yi = 0.0f;
+	// Whole palette once from the first to the last escaping pixel
+	const float4 col = read_imagef(palette, histogramSampler, share);
+	write_imagef(res, (int2)(x, y), (float4)(clamp(col.xyz * exposure, 0.0f, 1.0f), 1.0f));
+}
+
+// **********************************************************************************
+// Mariani-Silver subdivision
+// Tiles are int2 origins of tileSize x tileSize squares, clipped to the image. Each level
+// iterates the tile borders, then classifies every tile: a border entirely inside the set is
+// filled, any other is split into four tiles for the next level, and tiles at the minimum
+// size (or too thin to have an interior) are iterated completely. Exterior tiles are never
+// filled: pixels are colored by the smooth count, which varies inside an escape band.
+// **********************************************************************************
+
+int2 TileExtent(int2 tile, int tileSize, int width, int height)
+{
+	return (int2)(min(tileSize, width - tile.x), min(tileSize, height - tile.y));
+}
+
+// k-th pixel along the border of a w x h rectangle (w, h >= 3)
+int2 TileBorderPixel(int k, int w, int h)
+{
+	if (k < w)
+		return (int2)(k, 0);
+	if (k < 2 * w)
+		return (int2)(k - w, h - 1);
+	if (k < 2 * w + h - 2)
+		return (int2)(0, 1 + k - 2 * w);
+	return (int2)(w - 1, 1 + k - 2 * w - (h - 2));
+}
+
+kernel void MarianiBorder(global const int2* tiles, int tileSize, int width, int height,
+	float dx, float dy, float scale, global float2* samples, int periodCheck, global int* earlyExits)
+{
+	const int2 tile = tiles[get_global_id(0)];
+	const int2 extent = TileExtent(tile, tileSize, width, height);
+	const int k = get_global_id(1);
+	if (extent.x < 3 || extent.y < 3 || k >= 2 * extent.x + 2 * extent.y - 4)
+		return;
+
+	// Borders shared with the parent tile are already valid
+	const int2 p = tile + TileBorderPixel(k, extent.x, extent.y);
+	const int idx = p.x + p.y * width;
+	if (samples[idx].x >= 0.0f)
+		return;
+
+	samples[idx] = IterateSmooth(p.x, p.y, width, height, dx, dy, scale, periodCheck, earlyExits);
+}
+
+// counts: fill, split and direct list sizes
+kernel void MarianiClassify(global const int2* tiles, int tileSize, int minTileSize, int width, int height,
+	global const float2* samples, global int2* fillTiles, global int2* splitTiles, global int2* directTiles, global int* counts)
+{
+	const int2 tile = tiles[get_global_id(0)];
+	const int2 extent = TileExtent(tile, tileSize, width, height);
+
+	if (extent.x < 3 || extent.y < 3 || tileSize <= minTileSize)
+	{
+		directTiles[atomic_inc(&counts[2])] = tile;
+		return;
+	}
+
+	bool isInterior = true;
+	for (int k = 0; k < 2 * extent.x + 2 * extent.y - 4 && isInterior; k++)
+	{
+		const int2 p = tile + TileBorderPixel(k, extent.x, extent.y);
+		isInterior = samples[p.x + p.y * width].x >= maxIter;
+	}
+
+	if (isInterior)
+	{
+		fillTiles[atomic_inc(&counts[0])] = tile;
+		return;
+	}
+
+	const int childSize = tileSize / 2;
+	for (int j = 0; j < 2; j++)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			const int2 child = tile + (int2)(i * childSize, j * childSize);
+			if (child.x < width && child.y < height)
+				splitTiles[atomic_inc(&counts[1])] = child;
+		}
+	}
+}
+
+// Interior of a tile whose border is inside the set takes the corner's (interior) sample
+kernel void MarianiFill(global const int2* tiles, int tileSize, int width, int height, global float2* samples)
+{
+	const int2 tile = tiles[get_global_id(0)];
+	const int2 extent = TileExtent(tile, tileSize, width, height);
+	const int k = get_global_id(1);
+	const int2 offset = (int2)(k % tileSize, k / tileSize);
+	if (offset.x < 1 || offset.y < 1 || offset.x >= extent.x - 1 || offset.y >= extent.y - 1)
+		return;
+
+	const int2 p = tile + offset;
+	samples[p.x + p.y * width] = samples[tile.x + tile.y * width];
+}
+
+kernel void MarianiDirect(global const int2* tiles, int tileSize, int width, int height,
+	float dx, float dy, float scale, global float2* samples, int periodCheck, global int* earlyExits)
+{
+	const int2 tile = tiles[get_global_id(0)];
+	const int2 extent = TileExtent(tile, tileSize, width, height);
+	const int k = get_global_id(1);
+	const int2 offset = (int2)(k % tileSize, k / tileSize);
+	if (offset.x >= extent.x || offset.y >= extent.y)
+		return;
+
+	const int2 p = tile + offset;
+	const int idx = p.x + p.y * width;
+	if (samples[idx].x >= 0.0f)
+		return;
+
+	samples[idx] = IterateSmooth(p.x, p.y, width, height, dx, dy, scale, periodCheck, earlyExits);
+}
+
+// **********************************************************************************
+// Perturbation (deep zoom)
+// **********************************************************************************
+
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+typedef double pert_t;
+typedef double2 pert2_t;
+#else
+typedef float pert_t;
+typedef float2 pert2_t;
+#endif
+
+// Iterates only the low precision delta dz against a host computed reference orbit Z:
+//   dz' = (2Z + dz) * dz + dc
+// The reference point is (dx, dy) of the view, so dc is the usual pixel mapping without the offset.
+// Glitches are avoided by rebasing (Zhuoran): whenever |Z + dz| < |dz| or the reference runs out,
+// continue from the full value z = Z + dz against the start of the orbit (Z_0 = 0).
+kernel void MandelPerturb(int2 size, global const pert2_t* orbit, int orbitLength, pert_t scale, global float2* samples, int step, int prevStep)
+{
+	const int x = get_global_id(0) * step;
+	const int y = get_global_id(1) * step;
+	const int width = size.x;
+	const int height = size.y;
+	if (x >= width || y >= height || ReuseSample(samples, x, y, width, prevStep))
+		return;
+
+	const pert2_t dc = (pert2_t)(((pert_t)(xMinMax.y - xMinMax.x) * x / width + xMinMax.x) / scale,
+		((pert_t)(yMinMax.y - yMinMax.x) * (height - y) / height + yMinMax.x) / scale);
+
+	pert2_t dz = (pert2_t)(0, 0);
+	pert2_t z = (pert2_t)(0, 0);
+	int m = 0;
 	int iter = 0;
-	while (xi * xi + yi * yi <= (1 << 16) && iter < maxIter)
+	while (iter < maxIter)
 	{
-		float xTemp = xi * xi - yi * yi + x0;
+		const pert2_t twoZdz = 2 * orbit[m] + dz;
+		dz = (pert2_t)(twoZdz.x * dz.x - twoZdz.y * dz.y, twoZdz.x * dz.y + twoZdz.y * dz.x) + dc;
+		m++;
+		iter++;
+
+		z = orbit[m] + dz;
+		const pert_t zMag = z.x * z.x + z.y * z.y;
+		if (zMag > BAILOUT)
+			break;
+
+		// Rebase
+		if (zMag < dz.x * dz.x + dz.y * dz.y || m == orbitLength - 1)
+		{
+			dz = z;
+			m = 0;
+		}
+	}
+
+	samples[x + y * width] = (float2)(iter, (float)(z.x * z.x + z.y * z.y));
+}
+
+#ifdef cl_khr_fp64
+bool InCardioidOrBulbF64(double x0, double y0)
+{
+	const double xq = x0 - 0.25;
+	const double q = xq * xq + y0 * y0;
+	if (q * (q + xq) <= 0.25 * y0 * y0)
+		return true;
+
+	const double xb = x0 + 1.0;
+	return xb * xb + y0 * y0 <= 0.0625;
+}
+
+// Escape-time loop in double, returns the sample (iter, |z|^2)
+float2 IterateF64(double x0, double y0, int periodCheck, global int* earlyExits)
+{
+	if (periodCheck >= 0 && InCardioidOrBulbF64(x0, y0))
+	{
+		atomic_inc(&earlyExits[0]);
+		return (float2)(maxIter, 0.0f);
+	}
+
+	double xi = 0.0;
+	double yi = 0.0;
+	double savedX = 0.0;
+	double savedY = 0.0;
+	int window = periodCheck;
+	int windowEnd = periodCheck;
+	int iter = 0;
+	while (xi * xi + yi * yi <= BAILOUT && iter < maxIter)
+	{
+		double xTemp = xi * xi - yi * yi + x0;
 		yi = 2 * xi * yi + y0;
 		xi = xTemp;
 		iter++;
+
+		// Brent periodicity, see IterateFloat
+		if (periodCheck > 0)
+		{
+			if (xi == savedX && yi == savedY)
+			{
+				atomic_inc(&earlyExits[1]);
+				iter = maxIter;
+				break;
+			}
+			if (iter == windowEnd)
+			{
+				savedX = xi;
+				savedY = yi;
+				window *= 2;
+				windowEnd += window;
+			}
+		}
 	}
 
-	float flIter = iter;
-	// Used to avoid floating point issues with points inside the set.
-	if (iter < maxIter)
+	return (float2)(iter, (float)(xi * xi + yi * yi));
+}
+
+// Native double precision variant of MandelSmooth
+kernel void MandelSmoothF64(int2 size, double dx, double dy, double scale, global float2* samples, int step, int prevStep,
+	int periodCheck, global int* earlyExits)
+{
+	const int x = get_global_id(0) * step;
+	const int y = get_global_id(1) * step;
+	const int width = size.x;
+	const int height = size.y;
+	if (x >= width || y >= height || ReuseSample(samples, x, y, width, prevStep))
+		return;
+
+	const double x0 = ((double)(xMinMax.y - xMinMax.x) * x / width + xMinMax.x) / scale + dx;
+	const double y0 = ((double)(yMinMax.y - yMinMax.x) * (height - y) / height + yMinMax.x) / scale + dy;
+
+	samples[x + y * width] = IterateF64(x0, y0, periodCheck, earlyExits);
+}
+#endif
+
+// **********************************************************************************
+// Double-single (float-float) arithmetic for devices without cl_khr_fp64.
+// A value is hi + lo with |lo| <= ulp(hi) / 2, giving ~44 bits of mantissa.
+// Contraction into fma would break the error-free transformations below.
+// **********************************************************************************
+
+#pragma OPENCL FP_CONTRACT OFF
+
+float2 ds_two_sum(float a, float b)
+{
+	const float s = a + b;
+	const float v = s - a;
+	return (float2)(s, (a - (s - v)) + (b - v));
+}
+
+float2 ds_quick_two_sum(float a, float b)
+{
+	const float s = a + b;
+	return (float2)(s, b - (s - a));
+}
+
+// Dekker split of a float into two 12 bit halves
+float2 ds_split(float a)
+{
+	const float c = 4097.0f * a;
+	const float hi = c - (c - a);
+	return (float2)(hi, a - hi);
+}
+
+float2 ds_two_prod(float a, float b)
+{
+	const float p = a * b;
+	const float2 as = ds_split(a);
+	const float2 bs = ds_split(b);
+	return (float2)(p, ((as.x * bs.x - p) + as.x * bs.y + as.y * bs.x) + as.y * bs.y);
+}
+
+float2 ds_add(float2 a, float2 b)
+{
+	float2 s = ds_two_sum(a.x, b.x);
+	s.y += a.y + b.y;
+	return ds_quick_two_sum(s.x, s.y);
+}
+
+float2 ds_mul(float2 a, float2 b)
+{
+	float2 p = ds_two_prod(a.x, b.x);
+	p.y += a.x * b.y + a.y * b.x;
+	return ds_quick_two_sum(p.x, p.y);
+}
+
+bool ds_le(float2 a, float2 b)
+{
+	return a.x < b.x || (a.x == b.x && a.y <= b.y);
+}
+
+bool InCardioidOrBulbDS(float2 x0, float2 y0)
+{
+	const float2 xq = ds_add(x0, (float2)(-0.25f, 0.0f));
+	const float2 y2 = ds_mul(y0, y0);
+	const float2 q = ds_add(ds_mul(xq, xq), y2);
+	if (ds_le(ds_mul(q, ds_add(q, xq)), 0.25f * y2))
+		return true;
+
+	const float2 xb = ds_add(x0, (float2)(1.0f, 0.0f));
+	return ds_le(ds_add(ds_mul(xb, xb), y2), (float2)(0.0625f, 0.0f));
+}
+
+// Escape-time loop in double-single, returns the sample (iter, |z|^2)
+float2 IterateDS(float2 x0, float2 y0, int periodCheck, global int* earlyExits)
+{
+	if (periodCheck >= 0 && InCardioidOrBulbDS(x0, y0))
 	{
-		// sqrt of inner term removed using log simplification rules.
-		float log_zn = log(xi * xi + yi * yi) / 2;
-		float nu = log(log_zn / log(2.0f)) / log(2.0f);
-		// Rearranging the potential function.
-		// Dividing log_zn by log(2) instead of log(N = 1<<8)
-		// because we want the entire palette to range from the
-		// center to radius 2, NOT our bailout radius.
-		flIter = iter + 1 - nu;
+		atomic_inc(&earlyExits[0]);
+		return (float2)(maxIter, 0.0f);
 	}
 
-	//const int i = iter % 16;
-	const int i = (int)floor(flIter) % 16;
-	//const float3 col = (iter < maxIter && iter > 0) ? cols[i] : (float3)(0.0f);
-	const float3 col1 = (iter < maxIter && iter > 0) ? cols[i] : (float3)(0.0f);
-	const float3 col2 = (iter < maxIter && iter > 0) ? cols[i + 1] : (float3)(0.0f);
-	const float3 col = lerp3(col1, col2, flIter - floor(flIter));
+	float2 xi = (float2)(0.0f, 0.0f);
+	float2 yi = (float2)(0.0f, 0.0f);
+	float4 saved = (float4)(0.0f);
+	int window = periodCheck;
+	int windowEnd = periodCheck;
+	int iter = 0;
+	while (xi.x * xi.x + yi.x * yi.x <= BAILOUT && iter < maxIter)
+	{
+		const float2 x2 = ds_mul(xi, xi);
+		const float2 y2 = ds_mul(yi, yi);
+		const float2 xy = ds_mul(xi, yi);
+		xi = ds_add(ds_add(x2, -y2), x0);
+		yi = ds_add(ds_add(xy, xy), y0);
+		iter++;
 
-	const float4 convCol = (float4)(col.xyz / 255.0f, 1.0f);
+		// Brent periodicity, see IterateFloat
+		if (periodCheck > 0)
+		{
+			if (all((float4)(xi, yi) == saved))
+			{
+				atomic_inc(&earlyExits[1]);
+				iter = maxIter;
+				break;
+			}
+			if (iter == windowEnd)
+			{
+				saved = (float4)(xi, yi);
+				window *= 2;
+				windowEnd += window;
+			}
+		}
+	}
 
-	write_imagef(res, (int2)(x, y), convCol);
+	return (float2)(iter, xi.x * xi.x + yi.x * yi.x);
 }
 
+// Double-single variant of MandelSmooth, dx and dy are split on the host as (hi, lo)
+kernel void MandelSmoothDS(int2 size, float2 dx, float2 dy, float scale, global float2* samples, int step, int prevStep,
+	int periodCheck, global int* earlyExits)
+{
+	const int x = get_global_id(0) * step;
+	const int y = get_global_id(1) * step;
+	const int width = size.x;
+	const int height = size.y;
+	if (x >= width || y >= height || ReuseSample(samples, x, y, width, prevStep))
+		return;
+
+	// The offset from (dx, dy) is small, only the sum needs the extra precision
+	const float2 x0 = ds_add(dx, (float2)(((xMinMax.y - xMinMax.x) * x / width + xMinMax.x) / scale, 0.0f));
+	const float2 y0 = ds_add(dy, (float2)(((yMinMax.y - yMinMax.x) * (height - y) / height + yMinMax.x) / scale, 0.0f));
+
+	samples[x + y * width] = IterateDS(x0, y0, periodCheck, earlyExits);
+}
+
+#pragma OPENCL FP_CONTRACT ON
+
 __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE |
 CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
 
-kernel void GaussianFilter(read_only image2d_t input, write_only image2d_t res)
+kernel void GaussianFilter(read_only image2d_t input, write_only image2d_t res, int2 size)
 {
 	//int k[9] = { -1, -1, -1, -1, 9, -1, -1, -1, -1 };
 	int k[9] = { 1, 2, 1, 2, 4, 2, 1, 2, 1 };
 	int x = get_global_id(0);
 	int y = get_global_id(1);
+	if (x >= size.x || y >= size.y)
+		return;
+
+	// The images may be larger than the frame, clamp to the frame edge like the sampler
+	int xm = max(x - 1, 0);
+	int xp = min(x + 1, size.x - 1);
+	int ym = max(y - 1, 0);
+	int yp = min(y + 1, size.y - 1);
 	float4 pixel =
 		k[0] * read_imagef(input, sampler,
-			(int2)(x - 1, y - 1)) +
+			(int2)(xm, ym)) +
 		k[1] * read_imagef(input, sampler,
-			(int2)(x, y - 1)) +
+			(int2)(x, ym)) +
 		k[2] * read_imagef(input, sampler,
-			(int2)(x + 1, y - 1)) +
+			(int2)(xp, ym)) +
 		k[3] * read_imagef(input, sampler,
-			(int2)(x - 1, y)) +
+			(int2)(xm, y)) +
 		k[4] * read_imagef(input, sampler,
 			(int2)(x, y)) +
 		k[5] * read_imagef(input, sampler,
-			(int2)(x + 1, y)) +
+			(int2)(xp, y)) +
 		k[6] * read_imagef(input, sampler,
-			(int2)(x - 1, y + 1)) +
+			(int2)(xm, yp)) +
 		k[7] * read_imagef(input, sampler,
-			(int2)(x, y + 1)) +
+			(int2)(x, yp)) +
 		k[8] * read_imagef(input, sampler,
-			(int2)(x + 1, y + 1));
+			(int2)(xp, yp));
 
 	pixel = (float4)(pixel.xyz / 16, 1.0f);
 	write_imagef(res, (int2)(x, y), pixel);
-}
\ No newline at end of file
+}
+
+// **********************************************************************************
+// Exponential map
+// A zoom into a fixed target is iterated once as a log-polar strip: column u is the angle
+// 2 pi u / width around the target and row v the radius radius0 * exp(-2 pi v / width), so
+// strip samples are square and every width / (2 pi) rows zoom in by a factor of e. Frames
+// of the zoom are resampled from the strip instead of being iterated. Rows are kept in a
+// ring of ringRows rows, row v at v % ringRows, holding only the rows frames still reach.
+// Strip samples are smooth iteration counts, maxIter inside the set.
+// **********************************************************************************
+
+// Offset of strip sample (u, v) from the target
+float2 ExpMapOffset(int u, int v, int width, float radius0)
+{
+	const float angleStep = 2.0f * M_PI_F / width;
+	const float r = radius0 * exp(-angleStep * v);
+	const float angle = angleStep * u;
+	return (float2)(r * cos(angle), r * sin(angle));
+}
+
+// Smooth iteration count of a sample, 0 for immediate escapes
+float StripValue(float2 sample)
+{
+	const int iter = (int)sample.x;
+	if (iter >= maxIter)
+		return maxIter;
+	if (iter <= 0)
+		return 0.0f;
+
+	return SmoothIteration(iter, sample.y);
+}
+
+// Sample (iter, |z|^2) that SmoothIteration turns back into the smooth count, so resampled
+// frames go through the usual coloring passes: iter + 1 - nu = smooth with log|z| = log(2) 2^nu
+float2 SmoothSample(float smooth)
+{
+	if (smooth >= maxIter)
+		return (float2)(maxIter, 0.0f);
+	if (smooth <= 0.0f)
+		return (float2)(0.0f, 0.0f);
+
+	const int iter = max((int)smooth, 1);
+	const float nu = iter + 1 - smooth;
+	return (float2)(iter, exp(2.0f * log(2.0f) * exp2(nu)));
+}
+
+// Rows [rowBegin, rowBegin + global size 1) of the strip in float
+kernel void ExpMapStrip(int width, int rowBegin, int ringRows, float dx, float dy, float radius0, global float* strip,
+	int periodCheck, global int* earlyExits)
+{
+	const int u = get_global_id(0);
+	const int v = rowBegin + get_global_id(1);
+	const float2 offset = ExpMapOffset(u, v, width, radius0);
+
+	float2 z;
+	const int iter = IterateFloat(dx + offset.x, dy + offset.y, BAILOUT, periodCheck, earlyExits, &z);
+	strip[u + (v % ringRows) * width] = StripValue((float2)(iter, z.x * z.x + z.y * z.y));
+}
+
+// Double-single strip rows, the target is split on the host as (hi, lo)
+kernel void ExpMapStripDS(int width, int rowBegin, int ringRows, float2 dx, float2 dy, float radius0, global float* strip,
+	int periodCheck, global int* earlyExits)
+{
+	const int u = get_global_id(0);
+	const int v = rowBegin + get_global_id(1);
+	const float2 offset = ExpMapOffset(u, v, width, radius0);
+
+	const float2 sample = IterateDS(ds_add(dx, (float2)(offset.x, 0.0f)), ds_add(dy, (float2)(offset.y, 0.0f)), periodCheck, earlyExits);
+	strip[u + (v % ringRows) * width] = StripValue(sample);
+}
+
+#ifdef cl_khr_fp64
+// Double precision strip rows
+kernel void ExpMapStripF64(int width, int rowBegin, int ringRows, double dx, double dy, float radius0, global float* strip,
+	int periodCheck, global int* earlyExits)
+{
+	const int u = get_global_id(0);
+	const int v = rowBegin + get_global_id(1);
+	const float2 offset = ExpMapOffset(u, v, width, radius0);
+
+	strip[u + (v % ringRows) * width] = StripValue(IterateF64(dx + offset.x, dy + offset.y, periodCheck, earlyExits));
+}
+#endif
+
+// Resamples one frame of the zoom from strip rows [firstRow, lastRow]. logRadius is
+// log(radius0 * scale) of the frame, so offsets from the target are in units of 1 / scale.
+kernel void ExpMapFrame(int2 size, global const float* strip, int width, int ringRows, int firstRow, int lastRow,
+	float logRadius, global float2* samples)
+{
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	if (x >= size.x || y >= size.y)
+		return;
+
+	// Pixel offset from the target, the mapping of MandelSmooth without dx, dy and the scale
+	const float ox = (xMinMax.y - xMinMax.x) * x / size.x + xMinMax.x;
+	const float oy = (yMinMax.y - yMinMax.x) * (size.y - y) / size.y + yMinMax.x;
+
+	const float angleStep = 2.0f * M_PI_F / width;
+	float angle = atan2(oy, ox);
+	if (angle < 0.0f)
+		angle += 2.0f * M_PI_F;
+	const float r = max(length((float2)(ox, oy)), FLT_MIN);
+	const float u = angle / angleStep;
+	const float v = clamp((logRadius - log(r)) / angleStep, (float)firstRow, (float)lastRow);
+
+	const int u0 = min((int)u, width - 1);
+	const int v0 = min((int)v, lastRow - 1);
+	const float fu = u - u0;
+	const float fv = v - v0;
+	global const float* row0 = strip + (v0 % ringRows) * width;
+	global const float* row1 = strip + ((v0 + 1) % ringRows) * width;
+	const int u1 = (u0 + 1) % width;
+	const float4 corners = (float4)(row0[u0], row0[u1], row1[u0], row1[u1]);
+
+	// Blending across the set boundary would invent escape counts, the nearest sample is used there
+	float smooth;
+	if (any(corners >= (float)maxIter) || any(corners <= 0.0f))
+		smooth = fv < 0.5f ? (fu < 0.5f ? corners.x : corners.y) : (fu < 0.5f ? corners.z : corners.w);
+	else
+		smooth = mix(mix(corners.x, corners.y, fu), mix(corners.z, corners.w, fu), fv);
+
+	samples[x + y * size.x] = SmoothSample(smooth);
+}
+
+// **********************************************************************************
+// Adaptive supersampling
+// The frame is iterated and colored with one sample per pixel as usual. AdaptiveDetect then
+// flags the pixels whose 3x3 neighborhood in the colored frame spans more than a threshold
+// (edges, filaments, palette bands too narrow for a pixel) and compacts them into a list,
+// and AdaptiveRefine iterates jittered subsamples for the listed pixels only and overwrites
+// them with the average color. Smooth gradients, most of the frame, are never iterated again.
+// **********************************************************************************
+
+// Integer hash (lowbias32) for subsample jitter
+uint HashInt(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+	return x;
+}
+
+// Uniform in [0, 1) from a hash
+float HashFloat(uint x)
+{
+	return (HashInt(x) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Appends the index of every pixel to refine to list, count[0] must start at 0. Flags are
+// gathered per work-group in local memory, so each group takes a single global atomic.
+kernel void AdaptiveDetect(int2 size, global const float2* samples, read_only image1d_t palette, float paletteScale,
+	float paletteOffset, float exposure, global const float* distance, float boundaryWidth, float threshold,
+	global int* list, global int* count)
+{
+	local int groupCount;
+	local int groupBase;
+
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	const bool first = get_local_id(0) == 0 && get_local_id(1) == 0;
+	if (first)
+		groupCount = 0;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	bool refine = false;
+	if (x < size.x && y < size.y)
+	{
+		// Color range of the neighborhood as ColorSamples shows it
+		float3 lo = (float3)(1.0f, 1.0f, 1.0f);
+		float3 hi = (float3)(0.0f, 0.0f, 0.0f);
+		for (int j = -1; j <= 1; j++)
+		{
+			for (int i = -1; i <= 1; i++)
+			{
+				const int index = clamp(x + i, 0, size.x - 1) + clamp(y + j, 0, size.y - 1) * size.x;
+				const float2 sample = samples[index];
+				const float4 col = PaletteColor((int)sample.x, sample.y, palette, paletteScale, paletteOffset, exposure);
+				const float3 shaded = BoundaryShade(col, distance, index, boundaryWidth).xyz;
+				lo = min(lo, shaded);
+				hi = max(hi, shaded);
+			}
+		}
+		refine = any(hi - lo > threshold);
+	}
+
+	int slot = 0;
+	if (refine)
+		slot = atomic_inc(&groupCount);
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (first && groupCount > 0)
+		groupBase = atomic_add(count, groupCount);
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if (refine)
+		list[groupBase + slot] = x + y * size.x;
+}
+
+// Cells of the 4x4 subsample grid, one per quadrant first so the first four are a pilot
+__constant int subsampleCells[16] = { 0, 10, 2, 8, 5, 15, 7, 13, 1, 11, 3, 9, 4, 14, 6, 12 };
+
+// Recolors the listed pixels from stratified subsamples, each jittered inside its 4x4 grid
+// cell by a hash of the pixel, the subsample and seed. Pixels whose four pilot subsamples
+// agree within threshold (the edge only grazed the neighborhood) stop there, the others
+// take all 16. The list length stays on the device, so work items stride over it instead of
+// the host sizing the launch. With storeResolved the unshaded average and its subsample
+// count also go to resolved, the temporal accumulation mean.
+kernel void AdaptiveRefine(int2 size, float dx, float dy, float scale, global const int* list, global const int* count,
+	float threshold, uint seed, int periodCheck, global int* earlyExits, read_only image1d_t palette, float paletteScale,
+	float paletteOffset, float exposure, global const float* distance, float boundaryWidth, write_only image2d_t res,
+	global float4* resolved, int storeResolved)
+{
+	const int total = count[0];
+	for (int i = get_global_id(0); i < total; i += get_global_size(0))
+	{
+		const int index = list[i];
+		const int x = index % size.x;
+		const int y = index / size.x;
+
+		float4 sum = (float4)(0.0f, 0.0f, 0.0f, 0.0f);
+		float3 lo = (float3)(1.0f, 1.0f, 1.0f);
+		float3 hi = (float3)(0.0f, 0.0f, 0.0f);
+		int subsamples = 16;
+		for (int s = 0; s < subsamples; s++)
+		{
+			const int cell = subsampleCells[s];
+			const uint hash = HashInt(index ^ seed) + 2 * cell;
+			const float jx = ((cell % 4) + HashFloat(hash)) / 4 - 0.5f;
+			const float jy = ((cell / 4) + HashFloat(hash + 1)) / 4 - 0.5f;
+			const float x0 = ((xMinMax.y - xMinMax.x) * (x + jx) / size.x + xMinMax.x) / scale + dx;
+			const float y0 = ((yMinMax.y - yMinMax.x) * (size.y - y - jy) / size.y + yMinMax.x) / scale + dy;
+
+			float2 z;
+			const int iter = IterateFloat(x0, y0, BAILOUT, periodCheck, earlyExits, &z);
+			const float4 col = PaletteColor(iter, z.x * z.x + z.y * z.y, palette, paletteScale, paletteOffset, exposure);
+			sum += col;
+			lo = min(lo, col.xyz);
+			hi = max(hi, col.xyz);
+			if (s == 3 && !any(hi - lo > threshold))
+				subsamples = 4;
+		}
+
+		const float4 mean = sum / subsamples;
+		if (storeResolved)
+			resolved[index] = (float4)(mean.xyz, subsamples);
+		write_imagef(res, (int2)(x, y), BoundaryShade(mean, distance, index, boundaryWidth));
+	}
+}
+
+// **********************************************************************************
+// Temporal accumulation
+// While the view and its coloring stand still, every frame iterates each pixel once more at
+// a sub-pixel jitter offset (one per frame, from a low-discrepancy sequence on the host) and
+// blends its color into a running mean, so the image converges to a supersampled one over
+// frames that would otherwise just repeat. The mean keeps the unshaded color in xyz and the
+// samples it holds in w. AccumulateSeed starts it from the center sample; AdaptiveRefine
+// then replaces the refined pixels with their subsample average, weighted by its count.
+// **********************************************************************************
+
+kernel void AccumulateSeed(int2 size, global const float2* samples, read_only image1d_t palette, float paletteScale,
+	float paletteOffset, float exposure, global float4* accum)
+{
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	if (x >= size.x || y >= size.y)
+		return;
+
+	const int index = x + y * size.x;
+	const float2 sample = samples[index];
+	const float4 col = PaletteColor((int)sample.x, sample.y, palette, paletteScale, paletteOffset, exposure);
+	accum[index] = (float4)(col.xyz, 1.0f);
+}
+
+kernel void AccumulateJittered(int2 size, float dx, float dy, float scale, float2 jitter, int periodCheck,
+	global int* earlyExits, read_only image1d_t palette, float paletteScale, float paletteOffset, float exposure,
+	global const float* distance, float boundaryWidth, global float4* accum, write_only image2d_t res)
+{
+	const int x = get_global_id(0);
+	const int y = get_global_id(1);
+	if (x >= size.x || y >= size.y)
+		return;
+
+	const int index = x + y * size.x;
+	float4 mean = accum[index];
+
+	const float x0 = ((xMinMax.y - xMinMax.x) * (x + jitter.x) / size.x + xMinMax.x) / scale + dx;
+	const float y0 = ((yMinMax.y - yMinMax.x) * (size.y - y - jitter.y) / size.y + yMinMax.x) / scale + dy;
+
+	float2 z;
+	const int iter = IterateFloat(x0, y0, BAILOUT, periodCheck, earlyExits, &z);
+	const float4 col = PaletteColor(iter, z.x * z.x + z.y * z.y, palette, paletteScale, paletteOffset, exposure);
+	mean.xyz += (col.xyz - mean.xyz) / (mean.w + 1.0f);
+	mean.w += 1.0f;
+
+	accum[index] = mean;
+	write_imagef(res, (int2)(x, y), BoundaryShade((float4)(mean.xyz, 1.0f), distance, index, boundaryWidth));
+}
@@ -1,18 +1,30 @@
 ﻿// Local Headers
 #include "glitter.hpp"
 #include <Shader.hpp>
+#include <Headless.hpp>
 
 // System Headers
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#ifndef _WIN32
+#define GLFW_EXPOSE_NATIVE_X11
+#define GLFW_EXPOSE_NATIVE_GLX
+#include <GLFW/glfw3native.h>
+#endif
 
 // Standard Headers
 #include <cstdio>
 #include <cstdlib>
-#include <direct.h>
+#include <algorithm>
+#include <cmath>
 
 Params params;
 float dt = 0.0f;                  
+bool view_dirty = true;
+// Palettes B cycles through; a switch recolors the next frame
+std::vector<std::string> palette_names = Palette::GetBuiltinNames();
+int palette_index = 0;
+bool palette_dirty = false;
 Timer main_timer;
 GUI* gui_pointer;
 
@@ -21,9 +33,24 @@ void CursorPositionCallback(GLFWwindow* window, double xpos, double ypos);
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void KeyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void WindowRefreshCallback(GLFWwindow* window);
+bool DeepZoomKey(int key);
+bool ColoringKey(int key);
 
 int main(int argc, char * argv[]) {
 
+    const Options options = ParseOptions(argc, argv);
+    params = options.params;
+
+    if (options.listDevices)
+    {
+        PrintDevices(EnumerateDevices(), options.headless ? DeviceMode::Headless : DeviceMode::Interactive);
+        return EXIT_SUCCESS;
+    }
+
+    // Headless mode: plain OpenCL context or the CPU backend, no window or GL interop
+    if (options.headless || options.cpu || options.cpuCheck || !options.sequence.empty())
+        return RunHeadless(options) ? EXIT_SUCCESS : EXIT_FAILURE;
+
     // Load GLFW and Create a Window
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -52,63 +79,66 @@ int main(int argc, char * argv[]) {
     glfwSetWindowRefreshCallback(mWindow, WindowRefreshCallback);
 
     // OpenCL initialization
-    std::vector<cl::Platform> all_platforms;
-    cl::Platform::get(&all_platforms);
-    if (all_platforms.size() == 0) {
-        std::cout << " No platforms found. Check OpenCL installation!\n";
-        exit(1);
-    }
-    cl::Platform default_platform = all_platforms[0];
-    std::cout << "Using platform: " << default_platform.getInfo<CL_PLATFORM_NAME>() << "\n";
-
-    std::vector<cl::Device> all_devices;
-    default_platform.getDevices(CL_DEVICE_TYPE_ALL, &all_devices);
+    const std::vector<DeviceInfo> all_devices = EnumerateDevices();
     if (all_devices.size() == 0) {
-        std::cout << " No devices found.\n";
+        std::cout << " No devices found. Check OpenCL installation!\n";
         exit(1);
     }
+    PrintDevices(all_devices, DeviceMode::Interactive);
 
-    default_device = all_devices[0];
-    std::cout << "Using device: " << default_device.getInfo<CL_DEVICE_NAME>() << "\n";
-
-    cl_context_properties properties[] =
+    // Best scoring device first; only the device driving the GL context can share it, so
+    // fall through the ranking until one accepts
+    cl_int err = CL_DEVICE_NOT_AVAILABLE;
+    for (const DeviceInfo& candidate : RankDevices(all_devices, DeviceMode::Interactive, options.device))
     {
-      CL_GL_CONTEXT_KHR, (cl_context_properties)wglGetCurrentContext(),
-      CL_WGL_HDC_KHR, (cl_context_properties)wglGetCurrentDC(),
-      CL_CONTEXT_PLATFORM, (cl_context_properties)default_platform(),
-      NULL
-    };
+        cl_context_properties properties[] =
+        {
+#ifdef _WIN32
+          CL_GL_CONTEXT_KHR, (cl_context_properties)wglGetCurrentContext(),
+          CL_WGL_HDC_KHR, (cl_context_properties)wglGetCurrentDC(),
+#else
+          CL_GL_CONTEXT_KHR, (cl_context_properties)glfwGetGLXContext(mWindow),
+          CL_GLX_DISPLAY_KHR, (cl_context_properties)glfwGetX11Display(),
+#endif
+          CL_CONTEXT_PLATFORM, (cl_context_properties)candidate.platform(),
+          NULL
+        };
+
+        const cl_device_id device_id = candidate.device();
+        context = clCreateContext(properties, 1, &device_id, NULL, NULL, &err);
+        if (err == CL_SUCCESS)
+        {
+            default_device = candidate.device;
+            std::cout << "Using device: " << candidate.name << " (" << candidate.platformName << ")\n";
+            break;
+        }
 
-    cl_int err = CL_SUCCESS;
-    context = clCreateContext(properties, 1, &default_device(), NULL, NULL, &err);
+        std::cout << "Error creating context on " << candidate.name << " " << err << "\n";
+    }
 
     if (err != CL_SUCCESS) {
-        std::cout << "Error creating context" << " " << err << "\n";
-        //exit(-1);
+        std::cout << "No device can share the OpenGL context\n";
+        exit(1);
     }
 
-    queue = cl::CommandQueue(context, default_device);
+    // Profiling gives dynamic resolution the kernel times
+    queue = cl::CommandQueue(context, default_device, CL_QUEUE_PROFILING_ENABLE);
+
+    // Split rendering gets its own context on every device, including this one
+    if (options.multiDevice && !multi_device.Init(params))
+        exit(1);
     
     // Read kernel source
-    char buffer[1024];
-    getcwd(buffer, 1024);
-    //std::string kernel_char(buffer);
-    //kernel_char += "\\..\\Glitter\\Sources\\gpu_src\\test.cl";
-    //kernel_char += "\\..\\Glitter\\Sources\\gpu_src\\mandel.cl";
-    GetModuleFileName(NULL, buffer, sizeof(buffer));
-    std::string kernel_char(buffer);
-    kernel_char += "\\..\\mandel.cl";
-    kernel_source = ReadFile2(kernel_char.c_str());
-    sources.push_back({ kernel_source.c_str(), kernel_source.length() });
-
-    // Build program and compile
-    program = cl::Program(context, sources);
-
-    if (program.build({ default_device }) != CL_SUCCESS)
-    {
-        std::cout << " Error building: " << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(default_device) << "\n";
+    kernel_source = ReadFile2(GetKernelPath().c_str());
+
+    // Build program and compile for the starting iteration limit and bailout
+    program_cache.Init(context, default_device, kernel_source);
+    const cl::Program* built_program = program_cache.Get(params.maxIter, params.bailout);
+    if (built_program == NULL)
         exit(1);
-    }
+    program = *built_program;
+    int program_max_iter = params.maxIter;
+    double program_bailout = params.bailout;
 
     // Prepare buffers
     debug_buffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(float) * mWidth * mHeight);
@@ -137,67 +167,63 @@ int main(int argc, char * argv[]) {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
     glEnableVertexAttribArray(2);
 
-    // OpenGL texture
-    unsigned int gl_texture;
-    glGenTextures(1, &gl_texture);
-    glBindTexture(GL_TEXTURE_2D, gl_texture); // all upcoming GL_TEXTURE_2D operations now have effect on this texture object
-    // set the texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	// set texture wrapping to GL_REPEAT (default wrapping method)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    // set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
     int width, height, nrChannels;
 
     height = mHeight;
     width = mWidth;
 
-    // Set empty
-    std::vector<GLubyte> emptyData(mWidth * mHeight * 4, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mWidth, mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, &emptyData[0]);
-
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    target_texture = clCreateFromGLTexture(context(), CL_MEM_READ_WRITE, GL_TEXTURE_2D, 0, gl_texture, &err);
-    std::cout << "Created CL Image2D with err:\t" << err << std::endl;
-    copy_texture = clCreateFromGLTexture(context(), CL_MEM_READ_WRITE, GL_TEXTURE_2D, 0, gl_texture, &err);
-    std::cout << "Created CL Image2D with err:\t" << err << std::endl;
-
-    // Flush GL queue        
-    glFinish();
-    glFlush();
+    // Shared OpenGL textures, one per frame in flight
+    if (!frame_pipeline.Init(context, default_device, width, height))
+        exit(1);
+    render_targets.Init(width, height);
 
     // Acquire shared objects
-    err = clEnqueueAcquireGLObjects(queue(), 1, &target_texture(), 0, NULL, NULL);
-    err = clEnqueueAcquireGLObjects(queue(), 1, &copy_texture(), 0, NULL, NULL);
-    std::cout << "Acquired GL objects with err:\t" << err << std::endl;
+    const cl::Image2D& startup_texture = frame_pipeline.BeginFrame(queue);
 
     // Set up kernels
     //tester = cl::Kernel(program, "tex_test");
-    //mandeler = cl::Kernel(program, "Mandel");
-    mandeler = cl::Kernel(program, "MandelSmooth");
     filter = cl::Kernel(program, "GaussianFilter");
+    iteration_stats.Init(context);
+    iteration_stats.Reset(queue);
+    mandel_variants.Init(default_device, program, iteration_stats.GetBuffer());
+    reprojection.Init(context, program, width, height);
+    mariani.Init(context, program, width, height, iteration_stats.GetBuffer());
+    histogram_coloring.Init(context, default_device, program, width, height);
+    sample_coloring.Init(context, program, width, height);
+    adaptive_sampling.Init(context, program, width, height, iteration_stats.GetBuffer());
+    temporal_accumulation.Init(context, program, width, height, iteration_stats.GetBuffer());
+    resolution_controller.Init(width, height);
+    if (!options.palette.empty())
+    {
+        Palette palette;
+        if (!palette.Find(options.palette))
+            exit(1);
+        sample_coloring.SetPalette(palette);
+        multi_device.SetPalette(palette);
+
+        // Files join the built-in palettes
+        palette_index = (int)(std::find(palette_names.begin(), palette_names.end(), options.palette) - palette_names.begin());
+        if (palette_index == (int)palette_names.size())
+            palette_names.push_back(options.palette);
+    }
+    deep_zoom.Init(context, default_device, program);
+    if (options.centerRe.empty())
+        deep_zoom.SetCenter(params.dx, params.dy);
+    else
+        deep_zoom.SetCenter(options.centerRe, options.centerIm);
     cl::NDRange global_test(width, height);
     //tester(cl::EnqueueArgs(queue, global_test), target_texture).wait();
-    mandeler(cl::EnqueueArgs(queue, global_test), target_texture, 0, 0, 1.0f).wait();
+    mandel_variants.Render(queue, reprojection.GetSamples(), width, height, params, Precision::Float);
+    sample_coloring.Render(queue, startup_texture, reprojection.GetSamples(), 1, params);
 
-    // We have to generate the mipmaps again!!!
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    // Release shared objects                                                          
-    err = clEnqueueReleaseGLObjects(queue(), 1, &target_texture(), 0, NULL, NULL);
-    std::cout << "Releasing GL objects with err:\t" << err << std::endl;
-    err = clEnqueueReleaseGLObjects(queue(), 1, &copy_texture(), 0, NULL, NULL);
-    std::cout << "Releasing GL objects with err:\t" << err << std::endl;
-
-    // Flush CL queue
-    err = clFinish(queue());
-    std::cout << "Finished CL queue with err:\t" << err << std::endl;
+    // Release shared objects, the first loop iteration shows the frame
+    frame_pipeline.EndFrame(queue);
 
     // Input information
     std::cout << "\n\nW or S: zoom (scale)\nA or D: offset horizontally\nE or Q: offset vertically\nR: reset parameters\nF: enable/disable filtering\n \
-        P: play/pause animation\n] or [: increase/decrease animation speed" << std::endl;
+        P: play/pause animation\n] or [: increase/decrease animation speed\n \
+        O: palette cycling\nB: next palette\nU or J: increase/decrease palette density\nL or K: increase/decrease exposure\n \
+        N: distance estimation\nX: adaptive anti-aliasing\nT: temporal accumulation\nV: dynamic resolution" << std::endl;
 
     // Initialize our GUI
     GUI gui = GUI(mWindow, main_timer);
@@ -206,6 +232,9 @@ int main(int argc, char * argv[]) {
 
     // Rendering Loop
     float time = glfwGetTime();
+    Params rendered_params = params;
+    // Progressive step of the samples on screen, the coloring pass needs it to fill blocks
+    int rendered_step = 1;
     while (glfwWindowShouldClose(mWindow) == false) {
         if (glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(mWindow, true);
@@ -220,20 +249,33 @@ int main(int argc, char * argv[]) {
         // Update Timer
         main_timer.UpdateTime();
 
-        // Flush GL queue        
-        glFinish();
-        glFlush();
-
-        // Acquire shared objects
-        err = clEnqueueAcquireGLObjects(queue(), 1, &target_texture(), 0, NULL, NULL);
-        err = clEnqueueAcquireGLObjects(queue(), 1, &copy_texture(), 0, NULL, NULL);
+        // Once a new window size settles, move everything sized by the frame to it: the
+        // shared targets switch size class, device buffers only grow
+        int framebuffer_width, framebuffer_height;
+        glfwGetFramebufferSize(mWindow, &framebuffer_width, &framebuffer_height);
+        if (render_targets.Update(framebuffer_width, framebuffer_height, time))
+        {
+            queue.finish();
+            width = render_targets.GetWidth();
+            height = render_targets.GetHeight();
+            if (!frame_pipeline.Resize(width, height) || !reprojection.Resize(width, height) || !mariani.Resize(width, height) ||
+                !adaptive_sampling.Resize(width, height) || !temporal_accumulation.Resize(width, height) ||
+                !multi_device.Resize(width, height))
+                exit(1);
+            histogram_coloring.Resize(width, height);
+            sample_coloring.Resize(width, height);
+            resolution_controller.Init(width, height);
+            global_test = cl::NDRange(width, height);
+            debug_buffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(float) * width * height);
+            progressive.Restart();
+            view_dirty = true;
+        }
 
         /*const float dx = cos(glfwGetTime());
         const float dy = 0;
         const float scale = glfwGetTime();*/
 
         // Animation stuff
-        float scale = params.scale;
         if (params.playAnimation)
         {
             params.animationTime += dt * params.animationSpeed;
@@ -242,60 +284,269 @@ int main(int argc, char * argv[]) {
             params.scale = 1.0f + params.animationTime;
         }
 
+        // Palette cycling only moves the palette, the samples are recolored
+        if (params.paletteCycle)
+            params.paletteOffset = std::fmod(params.paletteOffset + dt * params.cycleSpeed, sample_coloring.GetPeriod());
+
         //mandeler(cl::EnqueueArgs(queue, global_test), target_texture, dx, dy, scale).wait();
-        mandeler(cl::EnqueueArgs(queue, global_test), target_texture, params.dx, params.dy, scale).wait();
+        // Iteration limit or bailout changed: switch the kernels to the matching program build
+        if (params.maxIter != program_max_iter || params.bailout != program_bailout)
+        {
+            const cl::Program* variant = program_cache.Get(params.maxIter, params.bailout);
+            if (variant == NULL)
+            {
+                params.maxIter = program_max_iter;
+                params.bailout = program_bailout;
+                variant = &program;
+            }
+
+            mandel_variants.SetProgram(*variant);
+            mariani.SetProgram(*variant);
+            deep_zoom.SetProgram(*variant);
+            histogram_coloring.SetProgram(*variant);
+            sample_coloring.SetProgram(*variant);
+            adaptive_sampling.SetProgram(*variant);
+            temporal_accumulation.SetProgram(*variant);
+            program = *variant;
+            program_max_iter = params.maxIter;
+            program_bailout = params.bailout;
+        }
 
-        // Image Copy parameters
-        static const size_t imageSize[3] = { width, height, 1 };
-        static const size_t imageOrigin[3] = { 0, 0, 0 };
+        // Split frames are rendered whole on every device, without pass reuse or perturbation
+        const bool splitFrame = options.multiDevice && mandel_variants.Select(params, width) != Precision::Perturbation;
 
-        if (params.filterOn)
+        // Cheapest arithmetic that still resolves the current zoom
+        const Precision precision = splitFrame ? multi_device.Select(params) : mandel_variants.Select(params, width);
+
+        // Pans reuse the cached samples and only iterate the exposed pixels; otherwise
+        // progressive mode renders one coarse-to-fine pass per frame and stops once refined
+        // Unchanged views are not rendered again, the last frame is just blitted
+        RenderPass pass;
+        bool renderFrame = view_dirty || params.playAnimation || !params.SameView(rendered_params);
+        int shiftX = 0;
+        int shiftY = 0;
+        if (renderFrame && !splitFrame && params.reproject && reprojection.Prepare(params, precision, shiftX, shiftY))
         {
-            filter(cl::EnqueueArgs(queue, global_test), target_texture, copy_texture).wait();
-            clEnqueueCopyImage(queue(), copy_texture(), target_texture(), imageOrigin, imageOrigin, imageSize, 0, NULL, NULL);
+            reprojection.Reproject(queue, shiftX, shiftY);
+            pass.prevStep = 1;
+            progressive.Complete(params);
+        }
+        else if (params.progressive && !splitFrame)
+            renderFrame = progressive.NextPass(params, pass);
+        else if (params.dynamicResolution && !splitFrame)
+        {
+            // Moving views render at the step that fits the frame budget, the first still
+            // frame completes the last one at full resolution from its samples
+            if (renderFrame)
+                pass.step = resolution_controller.GetStep();
+            else if (rendered_step > 1)
+            {
+                renderFrame = true;
+                pass.prevStep = rendered_step;
+            }
         }
 
-        // We have to generate the mipmaps again!!!
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // Release shared objects                                                          
-        err = clEnqueueReleaseGLObjects(queue(), 1, &target_texture(), 0, NULL, NULL);
-        err = clEnqueueReleaseGLObjects(queue(), 1, &copy_texture(), 0, NULL, NULL);
+        // Coloring changes of an unchanged view only run the coloring pass over the cached
+        // samples. Split frames keep their samples on the devices and render again.
+        bool recolorFrame = !renderFrame && (palette_dirty || !params.SameColoring(rendered_params));
+        if (recolorFrame && splitFrame)
+        {
+            renderFrame = true;
+            recolorFrame = false;
+        }
 
-        // Flush CL queue
-        err = clFinish(queue());
+        // A stationary, complete float frame keeps converging instead of idling: each frame
+        // adds one jittered sample per pixel until there are params.accumulateFrames
+        const bool accumulateFrame = !renderFrame && !recolorFrame && params.accumulate && !splitFrame && rendered_step == 1 &&
+            precision == Precision::Float && !params.histogram && temporal_accumulation.GetFrames() < params.accumulateFrames;
 
-        // bind Texture
-        glBindTexture(GL_TEXTURE_2D, gl_texture);
+        if (renderFrame || recolorFrame || accumulateFrame)
+        {
+            // Acquire shared objects
+            const cl::Image2D& target_texture = frame_pipeline.BeginFrame(queue);
+            const cl::Buffer& samples = reprojection.GetSamples();
+            if (renderFrame)
+            {
+                // Passes over the whole grid are timed for the resolution controller
+                cl::Event kernel_event;
+                cl::Event* timed_event = params.dynamicResolution && pass.prevStep == 0 ? &kernel_event : NULL;
+
+                iteration_stats.Reset(queue);
+                if (splitFrame)
+                {
+                    if (multi_device.Render(params, precision))
+                        multi_device.Upload(queue, target_texture);
+                }
+                else if (precision == Precision::Perturbation)
+                {
+                    if (!params.deepZoom)
+                        deep_zoom.SetCenter(params.dx, params.dy);
+                    deep_zoom.Render(queue, samples, width, height, params.scale, params.maxIter, params.bailout, pass, timed_event);
+                }
+                else if (params.distanceEstimate && precision == Precision::Float)
+                    mandel_variants.RenderDistance(queue, samples, reprojection.GetDistance(), width, height, params, pass, timed_event);
+                // Mariani-Silver runs many launches, none of them timed; timed frames iterate
+                // the plain grid so the resolution controller keeps getting measurements
+                else if (params.mariani && precision == Precision::Float && pass.prevStep == 0 && pass.step == 1 &&
+                    timed_event == NULL)
+                    mariani.Render(queue, samples, params);
+                else
+                    mandel_variants.Render(queue, samples, width, height, params, precision, pass, timed_event);
+
+                // Only the float variant estimates distances, other views mark them unknown
+                if (params.distanceEstimate && (precision != Precision::Float || splitFrame))
+                    queue.enqueueFillBuffer(reprojection.GetDistance(), -1.0f, 0, sizeof(cl_float) * width * height);
+
+                if (kernel_event() != NULL)
+                    resolution_controller.Submit(kernel_event, pass.step);
+
+                iteration_stats.Read(queue, false);
+                rendered_step = pass.step;
+
+                // Only complete full resolution frames can be reprojected later
+                if (pass.step == 1 && !splitFrame)
+                    reprojection.Store(params, precision);
+                else
+                    reprojection.Invalidate();
+
+                gui.precision = PrecisionName(precision);
+            }
+
+            // Split frames arrive colored. Coarse passes only hold samples on their grid and
+            // keep the smooth palette. Anti-aliasing iterates subsamples in float, so it follows
+            // complete float frames, recolors included.
+            if (accumulateFrame)
+                temporal_accumulation.Render(queue, target_texture, &reprojection.GetDistance(), sample_coloring, params);
+            else if (!splitFrame)
+            {
+                if (params.histogram && rendered_step == 1)
+                    histogram_coloring.Render(queue, target_texture, samples, sample_coloring, params);
+                else
+                {
+                    sample_coloring.Render(queue, target_texture, samples, rendered_step, params, 0, -1, &reprojection.GetDistance());
+                    // Accumulation continues from this frame as shown, refined pixels included
+                    const bool resolveFrame = rendered_step == 1 && precision == Precision::Float;
+                    if (params.accumulate && resolveFrame)
+                        temporal_accumulation.Seed(queue, samples, sample_coloring, params);
+                    if (params.antialias && resolveFrame)
+                        adaptive_sampling.Render(queue, target_texture, samples, &reprojection.GetDistance(), sample_coloring, params, 0,
+                            params.accumulate ? &temporal_accumulation.GetBuffer() : NULL);
+                }
+            }
+
+            // Image Copy parameters, the frame is the top-left corner of the target
+            const size_t imageSize[3] = { (size_t)width, (size_t)height, 1 };
+            static const size_t imageOrigin[3] = { 0, 0, 0 };
+
+            if (params.filterOn)
+            {
+                const cl::Image2D& copy_texture = frame_pipeline.GetScratch();
+                cl_int2 frame_size;
+                frame_size.s[0] = width;
+                frame_size.s[1] = height;
+                filter(cl::EnqueueArgs(queue, global_test), target_texture, copy_texture, frame_size);
+                clEnqueueCopyImage(queue(), copy_texture(), target_texture(), imageOrigin, imageOrigin, imageSize, 0, NULL, NULL);
+            }
+
+            // Release shared objects and flush, the frame is shown next iteration
+            frame_pipeline.EndFrame(queue);
+            rendered_params = params;
+            view_dirty = false;
+            palette_dirty = false;
+            if (!accumulateFrame)
+                temporal_accumulation.Reset();
+        }
 
-        // Bind Framebuffer
-        static GLuint fboId = 0;
-        glGenFramebuffers(1, &fboId);
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, fboId);
+        iteration_stats.Update();
+        adaptive_sampling.Update();
+        resolution_controller.Update(params.frameBudget);
+
+        gui.scale = params.scale;
+        gui.maxIter = params.maxIter;
+        gui.bailout = params.bailout;
+        gui.programCount = (int)program_cache.GetProgramCount();
+        gui.programBinaryHits = program_cache.GetBinaryHits();
+        gui.deepZoom = params.deepZoom;
+        gui.referenceLength = deep_zoom.GetReferenceLength();
+        gui.progressive = params.progressive;
+        gui.progressivePass = progressive.GetPass();
+        gui.reprojected = pass.prevStep == 1;
+        gui.mariani = params.mariani;
+        gui.marianiFilled = mariani.GetFilledFraction();
+        gui.interiorChecks = params.interiorChecks;
+        gui.histogram = params.histogram;
+        gui.distanceEstimate = params.distanceEstimate;
+        gui.boundaryWidth = params.boundaryWidth;
+        gui.antialias = params.antialias;
+        gui.antialiasThreshold = params.antialiasThreshold;
+        gui.antialiasRefined = adaptive_sampling.GetRefinedFraction();
+        gui.dynamicResolution = params.dynamicResolution;
+        gui.renderStep = rendered_step;
+        gui.kernelTime = resolution_controller.GetKernelTime();
+        gui.frameBudget = params.frameBudget;
+        gui.accumulate = params.accumulate;
+        gui.accumulatedFrames = temporal_accumulation.GetFrames();
+        gui.accumulateFrames = params.accumulateFrames;
+        gui.palette = palette_names[palette_index].c_str();
+        gui.paletteOffset = params.paletteOffset;
+        gui.paletteDensity = params.paletteDensity;
+        gui.exposure = params.exposure;
+        gui.paletteCycle = params.paletteCycle;
+        gui.rendered = renderFrame;
+        gui.recolored = recolorFrame;
+        gui.cardioidExits = splitFrame ? (int)multi_device.GetCardioidExits() : iteration_stats.GetCardioidExits();
+        gui.periodicExits = splitFrame ? (int)multi_device.GetPeriodicExits() : iteration_stats.GetPeriodicExits();
+        gui.splitDevices.clear();
+        for (int device = 0; splitFrame && device < multi_device.GetDeviceCount(); device++)
+        {
+            char line[256];
+            snprintf(line, sizeof(line), "%s: %.1f%% (%.2f ms)", multi_device.GetDeviceName(device).c_str(),
+                multi_device.GetShare(device) * 100.0, multi_device.GetKernelTime(device));
+            gui.splitDevices.push_back(line);
+        }
 
-        // Render texture directly
-        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-            GL_TEXTURE_2D, gl_texture, 0);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        /*glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
-            GL_COLOR_BUFFER_BIT, GL_NEAREST);*/
-        glBlitFramebuffer(0, 0, width, height, 0, 0, mWidth, mHeight,
-            GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        // Render texture directly, the newest frame the device has finished
+        frame_pipeline.Present(framebuffer_width, framebuffer_height);
 
         // Render GUI
         if (gui.gui_enabled)
             gui.Render();
 
+        // Iteration settings edited in the GUI apply from the next frame
+        params.maxIter = gui.maxIter;
+        params.bailout = gui.bailout;
+        params.ClampIterations();
+        params.paletteOffset = gui.paletteOffset;
+        params.paletteDensity = gui.paletteDensity;
+        params.exposure = gui.exposure;
+        params.paletteCycle = gui.paletteCycle;
+        params.boundaryWidth = gui.boundaryWidth;
+        params.antialiasThreshold = gui.antialiasThreshold;
+        params.accumulateFrames = gui.accumulateFrames;
+        params.frameBudget = std::max(gui.frameBudget, minFrameBudget);
+        params.ClampColoring();
+
         // Reset input flags
         gui.ResetInputFlags();
 
         // Flip Buffers and Draw
         glfwSwapBuffers(mWindow);
-        glfwPollEvents();
+
+        // Sleep until the next input once everything rendered is on screen
+        if (params.idleWait && !renderFrame && !recolorFrame && !accumulateFrame && !params.playAnimation && !params.paletteCycle &&
+            !frame_pipeline.HasPendingFrame() && !render_targets.IsPending())
+        {
+            glfwWaitEvents();
+            time = glfwGetTime();
+        }
+        else
+            glfwPollEvents();
     }
     
     // Cleanup GUI
     gui.Cleanup();
+    queue.finish();
+    frame_pipeline.Cleanup();
 
     glfwTerminate();
     
@@ -349,6 +600,17 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 /// <param name="mods"></param>
 void KeyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
+    // Coloring keys leave the view alone
+    if (action == GLFW_PRESS && ColoringKey(key))
+        return;
+
+    // Deep zoom pans can be smaller than a double step of dx, so any key redraws
+    if (action == GLFW_PRESS)
+        view_dirty = true;
+
+    if (params.deepZoom && action == GLFW_PRESS && DeepZoomKey(key))
+        return;
+
     if ((key == GLFW_KEY_W || key == GLFW_PRESS) && action == GLFW_PRESS)
         params.scale += force * dt;
     else if ((key == GLFW_KEY_S || key == GLFW_KEY_DOWN) && action == GLFW_PRESS)
@@ -367,6 +629,43 @@ void KeyboardCallback(GLFWwindow* window, int key, int scancode, int action, int
         params.Reset();
     else if (key == GLFW_KEY_P && action == GLFW_PRESS)
         params.playAnimation = !params.playAnimation;
+    else if (key == GLFW_KEY_C && action == GLFW_PRESS)
+        params.reproject = !params.reproject;
+    else if (key == GLFW_KEY_M && action == GLFW_PRESS)
+        params.mariani = !params.mariani;
+    else if (key == GLFW_KEY_I && action == GLFW_PRESS)
+        params.interiorChecks = !params.interiorChecks;
+    else if (key == GLFW_KEY_H && action == GLFW_PRESS)
+        params.histogram = !params.histogram;
+    else if (key == GLFW_KEY_N && action == GLFW_PRESS)
+        params.distanceEstimate = !params.distanceEstimate;
+    else if (key == GLFW_KEY_X && action == GLFW_PRESS)
+        params.antialias = !params.antialias;
+    else if (key == GLFW_KEY_T && action == GLFW_PRESS)
+        params.accumulate = !params.accumulate;
+    else if (key == GLFW_KEY_V && action == GLFW_PRESS)
+        params.dynamicResolution = !params.dynamicResolution;
+    else if (key == GLFW_KEY_PERIOD && action == GLFW_PRESS)
+    {
+        params.maxIter *= 2;
+        params.ClampIterations();
+    }
+    else if (key == GLFW_KEY_COMMA && action == GLFW_PRESS)
+    {
+        params.maxIter /= 2;
+        params.ClampIterations();
+    }
+    else if (key == GLFW_KEY_G && action == GLFW_PRESS)
+    {
+        params.progressive = !params.progressive;
+        progressive.Restart();
+    }
+    else if (key == GLFW_KEY_Z && action == GLFW_PRESS)
+    {
+        params.deepZoom = !params.deepZoom;
+        if (params.deepZoom)
+            deep_zoom.SetCenter(params.dx, params.dy);
+    }
     else if (key == GLFW_KEY_LEFT_BRACKET && action == GLFW_PRESS)
     {
         params.animationSpeed = (params.animationSpeed - 0.2f < 0.1f) ? 0.1f : params.animationSpeed - 0.2f;
@@ -399,3 +698,89 @@ void WindowRefreshCallback(GLFWwindow* window)
     glfwGetWindowSize(window, &mWidth, &mHeight);
     glViewport(0, 0, mWidth, mHeight);
 }
+
+/// <summary>
+/// Deep zoom navigation: exponential zoom, and pans relative to the view size
+/// applied to the full precision reference point
+/// </summary>
+/// <param name="key"></param>
+/// <returns>true if the key was handled</returns>
+bool DeepZoomKey(int key)
+{
+    const double step = force * dt / params.scale;
+
+    switch (key)
+    {
+    case GLFW_KEY_W:
+    case GLFW_KEY_UP:
+        params.scale *= 1.0 + force * dt;
+        return true;
+    case GLFW_KEY_S:
+    case GLFW_KEY_DOWN:
+        params.scale = std::max(1.0, params.scale / (1.0 + force * dt));
+        return true;
+    case GLFW_KEY_D:
+    case GLFW_KEY_RIGHT:
+        params.dx += step;
+        deep_zoom.Offset(step, 0.0);
+        return true;
+    case GLFW_KEY_A:
+    case GLFW_KEY_LEFT:
+        params.dx -= step;
+        deep_zoom.Offset(-step, 0.0);
+        return true;
+    case GLFW_KEY_E:
+        params.dy += step;
+        deep_zoom.Offset(0.0, step);
+        return true;
+    case GLFW_KEY_Q:
+        params.dy -= step;
+        deep_zoom.Offset(0.0, -step);
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// <summary>
+/// Palette cycling, density and exposure, applied by the coloring pass alone
+/// </summary>
+/// <param name="key"></param>
+/// <returns>true if the key was handled</returns>
+bool ColoringKey(int key)
+{
+    switch (key)
+    {
+    case GLFW_KEY_O:
+        params.paletteCycle = !params.paletteCycle;
+        return true;
+    case GLFW_KEY_B:
+    {
+        Palette palette;
+        palette_index = (palette_index + 1) % (int)palette_names.size();
+        if (palette.Find(palette_names[palette_index]) && sample_coloring.SetPalette(palette))
+        {
+            multi_device.SetPalette(palette);
+            palette_dirty = true;
+        }
+        return true;
+    }
+    case GLFW_KEY_U:
+        params.paletteDensity *= 1.25f;
+        break;
+    case GLFW_KEY_J:
+        params.paletteDensity /= 1.25f;
+        break;
+    case GLFW_KEY_L:
+        params.exposure *= 1.25f;
+        break;
+    case GLFW_KEY_K:
+        params.exposure /= 1.25f;
+        break;
+    default:
+        return false;
+    }
+
+    params.ClampColoring();
+    return true;
+}